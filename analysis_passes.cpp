@@ -0,0 +1,94 @@
+#include "analysis_passes.hpp"
+#include <sstream>
+
+namespace
+{
+	struct analysis_pass_info
+	{
+		analysis_pass pass;
+		const char* name;
+		// Passes whose results this one reads. The used marks also carry
+		// over to later refutations, which stop at the learned clauses an
+		// earlier one used
+		analysis_passes depends;
+		// Keys of the statistics line the pass fills in, nullptr terminated
+		const char* metrics[5];
+	};
+
+	const analysis_pass_info registry[] = {
+		{pass_used, "used", 0, {"used_axioms", "used_intermediate", "used_learned", "earlier_used_learned", nullptr}},
+		{pass_unused, "unused", pass_used, {"unused_axioms", "unused_intermediate", "unused_learned", nullptr}},
+		{pass_width, "width", pass_used, {"max_width", nullptr}},
+		{pass_regularity, "regularity", pass_used, {"regularity_violations_total", "regularity_violation_variables", nullptr}},
+		{pass_tree_violations, "tree_violations", pass_used, {"tree_edge_violations", "tree_vertex_violations", nullptr}},
+		{pass_proof_dag, "proof_dag", pass_used, {nullptr}},
+		{pass_copy_cost, "copy_cost", pass_proof_dag, {"tree_copy_cost", "depth", nullptr}},
+		{pass_clause_space, "clause_space", pass_proof_dag, {"clause_space", "new_clause_space", nullptr}},
+		{pass_export, "export", pass_proof_dag, {nullptr}}
+	};
+
+	bool select(const std::string& name, analysis_passes& passes)
+	{
+		if(name == "all")
+		{
+			passes |= all_passes;
+			return true;
+		}
+
+		for(const analysis_pass_info& info : registry)
+		{
+			bool found = name == info.name;
+			for(int i=0; ! found && info.metrics[i] != nullptr; i++) found = name == info.metrics[i];
+			if( ! found) continue;
+
+			passes |= info.pass;
+			return true;
+		}
+		return false;
+	}
+}
+
+analysis_passes required_passes(analysis_passes passes)
+{
+	// The registry lists every pass after the ones it depends on
+	for(int i=sizeof(registry) / sizeof(registry[0]) - 1; i >= 0; i--)
+	{
+		if(passes & registry[i].pass) passes |= registry[i].depends;
+	}
+	return passes;
+}
+
+bool parse_metrics(const std::string& list, analysis_passes& passes, std::string& unknown)
+{
+	passes = 0;
+	std::istringstream in(list);
+	std::string name;
+	while(std::getline(in, name, ','))
+	{
+		if(name.empty()) continue;
+		if( ! select(name, passes))
+		{
+			unknown = name;
+			return false;
+		}
+	}
+
+	passes = required_passes(passes);
+	return true;
+}
+
+std::string metric_names()
+{
+	std::ostringstream out;
+	out << "all";
+	for(const analysis_pass_info& info : registry)
+	{
+		out << ", " << info.name;
+		if(info.metrics[0] == nullptr) continue;
+
+		out << " (";
+		for(int i=0; info.metrics[i] != nullptr; i++) out << (i > 0 ? ", " : "") << info.metrics[i];
+		out << ")";
+	}
+	return out.str();
+}
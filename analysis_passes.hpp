@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+// The analyses ResolutionGraph runs on a refutation. Each is a bit, so that a
+// selection of passes is a mask
+//
+// The used traversal classifies the clauses of the refutation and is always
+// run. Width, regularity and tree violations are counted during that same
+// traversal, and tree_copy_cost, depth and clause space share a single flat
+// copy of the used proof (ProofDag), which export then takes over for the
+// proof files, --reuse and --compress
+enum analysis_pass
+{
+	pass_used = 1,
+	pass_unused = 2,
+	pass_width = 4,
+	pass_regularity = 8,
+	pass_tree_violations = 16,
+	pass_proof_dag = 32,
+	pass_copy_cost = 64,
+	pass_clause_space = 128,
+	pass_export = 256,
+	// Every statistic. Export is only run for the options that need it
+	all_passes = 255
+};
+
+typedef unsigned analysis_passes;
+
+// Adds the passes the given ones depend on (see the registry in
+// analysis_passes.cpp)
+analysis_passes required_passes(analysis_passes passes);
+
+// Parses a comma separated list of pass names and statistics (the keys of
+// the statistics line, like max_width), where a statistic selects the pass
+// that computes it. Returns false with the first unknown name in unknown
+bool parse_metrics(const std::string& list, analysis_passes& passes, std::string& unknown);
+
+// Pass names and their statistics, for the help text
+std::string metric_names();
@@ -0,0 +1,233 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <boost/program_options.hpp>
+#include "literal.hpp"
+#include "clause.hpp"
+#include "solver_shadow.hpp"
+#include "resolution_graph.hpp"
+#include "proof_events.hpp"
+#include "trace_reader.hpp"
+#include "memory_accounting.hpp"
+#include "trace_generator.hpp"
+
+// Microbenchmarks for the hot paths of the tool. Every benchmark prints one
+// JSON line with its throughput and the peak RSS of the process so far (peak
+// RSS never goes down, so benchmarks are ordered by expected memory use)
+
+namespace
+{
+	// Keeps the compiler from optimizing away benchmarked work
+	volatile long long sink;
+
+	template<class F>
+	double seconds(F f)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void report(const std::string& name, long long operations, double elapsed)
+	{
+		std::cout << "{\"benchmark\": \"" << name << "\", \"operations\": " << operations
+			<< ", \"seconds\": " << elapsed << ", \"operations_per_second\": " << (elapsed > 0 ? operations / elapsed : 0)
+			<< ", \"peak_rss_kb\": " << peak_rss_kb() << "}" << std::endl;
+	}
+
+	Literal literal(int variable, bool negated)
+	{
+		return Literal((negated ? "~" : "") + std::to_string(variable));
+	}
+
+	void bench_literal_parsing(long long count)
+	{
+		std::mt19937_64 random(1);
+		std::vector<std::string> strings;
+		for(int i=0; i < 4096; i++) strings.push_back((random() % 2 ? "~" : "") + std::to_string(random() % 100000));
+
+		double elapsed = seconds([&]()
+		{
+			long long sum = 0;
+			for(long long i=0; i < count; i++) sum += Literal(strings[i % strings.size()]).variable();
+			sink = sum;
+		});
+
+		report("literal_parse", count, elapsed);
+	}
+
+	void bench_resolve(long long count, int width)
+	{
+		// Pairs of random clauses over disjoint variable ranges that clash on
+		// exactly one variable
+		std::mt19937_64 random(2);
+		std::vector<std::pair<clause_ref, clause_ref> > pairs;
+		for(int i=0; i < 1024; i++)
+		{
+			std::vector<Literal> first, second;
+			first.push_back(literal(0, false));
+			second.push_back(literal(0, true));
+			for(int j=1; j < width; j++)
+			{
+				first.push_back(literal(j, random() % 2));
+				second.push_back(literal(width + j, random() % 2));
+			}
+			pairs.push_back(std::make_pair(std::make_shared<const Clause>(Clause(first)), std::make_shared<const Clause>(Clause(second))));
+		}
+
+		double elapsed = seconds([&]()
+		{
+			long long total = 0;
+			for(long long i=0; i < count; i++)
+			{
+				const std::pair<clause_ref, clause_ref>& p = pairs[i % pairs.size()];
+				total += Clause::resolve(p.first, p.second)->width();
+			}
+			sink = total;
+		});
+
+		report("clause_resolve_width_" + std::to_string(width), count, elapsed);
+	}
+
+	void bench_propagate_backtrack(long long rounds, int num_vars)
+	{
+		// Deciding variable 0 implies every other variable through (~0 v)
+		SolverShadow<none> solver;
+		solver.num_vars(num_vars);
+		std::vector<Literal> implied;
+		for(int v=1; v < num_vars; v++)
+		{
+			std::vector<Literal> literals = {literal(0, true), literal(v, false)};
+			solver.add_clause(std::make_shared<const Clause>(Clause(literals)), v);
+			implied.push_back(literal(v, false));
+		}
+		Literal decision = literal(0, false);
+
+		double elapsed = seconds([&]()
+		{
+			for(long long r=0; r < rounds; r++)
+			{
+				solver.decide(decision);
+				for(int v=1; v < num_vars; v++) solver.propagate(implied[v - 1], v);
+				solver.backtrack(0);
+			}
+		});
+
+		report("shadow_propagate_backtrack", rounds * num_vars, elapsed);
+	}
+
+	void bench_relocate(long long rounds, int num_clauses)
+	{
+		SolverShadow<none> solver;
+		solver.num_vars(2);
+		std::vector<Literal> literals = {literal(0, false), literal(1, false)};
+		for(int i=0; i < num_clauses; i++) solver.add_clause(std::make_shared<const Clause>(Clause(literals)), 2 * i);
+
+		// Alternate between even and odd crefs, so every round moves every clause
+		std::vector<std::pair<int, int> > forward, back;
+		for(int i=0; i < num_clauses; i++)
+		{
+			forward.push_back(std::make_pair(2 * i, 2 * i + 1));
+			back.push_back(std::make_pair(2 * i + 1, 2 * i));
+		}
+
+		double elapsed = seconds([&]()
+		{
+			for(long long r=0; r < rounds; r++) solver.relocate(r % 2 == 0 ? forward : back);
+		});
+
+		report("shadow_relocate", rounds * num_clauses, elapsed);
+	}
+
+	void bench_minimize_full(long long rounds, int chain_length)
+	{
+		// Decision d = 0 implies 1, 2, ..., chain_length through (~(v - 1) v).
+		// Removing ~chain_length from (~0 ~chain_length) temporarily introduces
+		// every literal in the chain
+		SolverShadow<none> solver;
+		solver.num_vars(chain_length + 1);
+		solver.decide(literal(0, false));
+		for(int v=1; v <= chain_length; v++)
+		{
+			std::vector<Literal> literals = {literal(v - 1, true), literal(v, false)};
+			solver.add_clause(std::make_shared<const Clause>(Clause(literals)), v);
+			solver.propagate(literal(v, false), v);
+		}
+
+		std::vector<Literal> initial = {literal(0, true), literal(chain_length, true)};
+		clause_ref learned = std::make_shared<const Clause>(Clause(initial));
+		std::vector<Literal> to_remove = {literal(chain_length, true)};
+
+		double elapsed = seconds([&]()
+		{
+			long long total = 0;
+			for(long long r=0; r < rounds; r++) total += solver.minimize_full(learned, to_remove)->width();
+			sink = total;
+		});
+
+		report("minimize_full", rounds * chain_length, elapsed);
+	}
+
+	void bench_replay(const generator_options& options)
+	{
+		std::ostringstream trace;
+		generator_result generated = generate_trace(options, trace);
+		std::istringstream input(trace.str());
+
+		ProofEvents<learn> events;
+		TraceReader<learn> reader(input, events, false);
+		int ref = -1;
+
+		double elapsed = seconds([&]()
+		{
+			reader.read_until_conflict(ref);
+		});
+		report("trace_replay_lines", generated.lines, elapsed);
+
+		statistics s;
+		elapsed = seconds([&]()
+		{
+			ResolutionGraph graph = events.on_final_conflict(ref, false);
+			s = graph.vertex_statistics();
+		});
+
+		long long nodes = s.used_axioms + s.used_intermediate + s.used_learned + s.unused_axioms + s.unused_intermediate + s.unused_learned;
+		report("resolution_graph_nodes", nodes, elapsed);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	double scale = 1;
+	generator_options options;
+	options.num_vars = 150;
+
+	boost::program_options::options_description desc("Supported options");
+	desc.add_options()
+		("help", "show this help")
+		("scale", boost::program_options::value<double>(&scale), "multiplier for the number of iterations")
+		("vars", boost::program_options::value<int>(&options.num_vars), "variables of the generated trace used for replay and graph construction")
+		("seed", boost::program_options::value<uint64_t>(&options.seed), "seed of the generated trace")
+	;
+
+	boost::program_options::variables_map vm;
+	boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+	boost::program_options::notify(vm);
+
+	if (vm.count("help"))
+	{
+		std::cout << desc << "\n";
+		return 1;
+	}
+
+	bench_literal_parsing(2000000 * scale);
+	bench_resolve(200000 * scale, 8);
+	bench_resolve(50000 * scale, 64);
+	bench_propagate_backtrack(200 * scale, 10000);
+	bench_relocate(20 * scale, 100000);
+	bench_minimize_full(2000 * scale, 100);
+	bench_replay(options);
+}
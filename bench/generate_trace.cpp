@@ -0,0 +1,46 @@
+#include <iostream>
+#include <boost/program_options.hpp>
+#include "trace_generator.hpp"
+
+// Prints a deterministic synthetic trace to standard output, so that it can
+// be piped to ResolutionGraph like a real minisat trace
+int main(int argc, char** argv)
+{
+	generator_options options;
+
+	boost::program_options::options_description desc("Supported options");
+	desc.add_options()
+		("help", "show this help")
+		("vars", boost::program_options::value<int>(&options.num_vars), "number of variables")
+		("width", boost::program_options::value<int>(&options.clause_width), "width of the input clauses")
+		("ratio", boost::program_options::value<double>(&options.ratio), "input clauses per variable")
+		("seed", boost::program_options::value<uint64_t>(&options.seed), "random seed")
+		("restart-interval", boost::program_options::value<int>(&options.restart_interval), "conflicts between restarts (RS), 0 disables restarts")
+		("reduce-interval", boost::program_options::value<int>(&options.reduce_interval), "conflicts between learned clause removals (R), 0 disables them")
+		("learn-keep", boost::program_options::value<double>(&options.learn_keep), "fraction of learned clauses kept at each removal")
+		("gc-interval", boost::program_options::value<int>(&options.gc_interval), "removals between relocations (M/RD), 0 disables them")
+		("skip-density", boost::program_options::value<double>(&options.skip_density), "probability that a level 0 literal is skipped (S) instead of kept")
+		("minimize-rate", boost::program_options::value<double>(&options.minimize_rate), "probability of minimizing a learned clause (MNM)")
+		("max-conflicts", boost::program_options::value<long>(&options.max_conflicts), "conflicts before trying the next seed")
+	;
+
+	boost::program_options::variables_map vm;
+	boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+	boost::program_options::notify(vm);
+
+	if (vm.count("help"))
+	{
+		std::cout << desc << "\n";
+		return 1;
+	}
+
+	if(options.num_vars < 1 || options.clause_width < 2 || options.clause_width > options.num_vars)
+	{
+		std::cout << "ERROR: Need at least one variable and a clause width between 2 and the number of variables" << std::endl;
+		return 1;
+	}
+
+	generator_result result = generate_trace(options, std::cout);
+	std::cerr << "{\"lines\": " << result.lines << ", \"conflicts\": " << result.conflicts << ", \"restarts\": " << result.restarts
+		<< ", \"relocations\": " << result.relocations << ", \"seed\": " << result.seed << "}" << std::endl;
+}
@@ -0,0 +1,557 @@
+#include "trace_generator.hpp"
+#include <vector>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <assert.h>
+
+namespace
+{
+	// Literals are encoded as 2 * variable + negated, like in minisat
+	inline int var(int lit) { return lit >> 1; }
+	inline bool negated(int lit) { return lit & 1; }
+	inline int negate(int lit) { return lit ^ 1; }
+
+	enum value { value_false = 0, value_true = 1, value_undef = 2 };
+
+	const int reason_decision = -1;
+	const int reason_unit = -2;
+
+	struct generator_clause
+	{
+		std::vector<int> literals;
+		int cref;
+		bool learned;
+		bool deleted;
+	};
+
+	// A deliberately small CDCL solver (two watched literals, VSIDS, first UIP
+	// learning, restarts, clause deletion and relocation) which prints each step
+	// in the trace format
+	class CdclGenerator
+	{
+	public:
+		CdclGenerator(const generator_options& _options, uint64_t seed, std::ostream& _out) :
+			options(_options), random(seed), out(_out), next_cref(0), qhead(0),
+			var_inc(1), conflicts(0), reductions(0), since_restart(0), since_reduce(0)
+		{
+		}
+
+		// Returns true if the instance was refuted, in which case the trace ends with C
+		bool run(generator_result& result);
+
+	private:
+		void print_literal(int lit)
+		{
+			if(negated(lit)) out << "~";
+			out << var(lit);
+		}
+		void print_clause(int cref, const std::vector<int>& literals)
+		{
+			out << cref << " " << literals.size();
+			for(int lit : literals)
+			{
+				out << " ";
+				print_literal(lit);
+			}
+		}
+
+		value literal_value(int lit) const
+		{
+			int v = assignment[var(lit)];
+			if(v == value_undef) return value_undef;
+			return (v == value_true) != negated(lit) ? value_true : value_false;
+		}
+		int decision_level() const { return trail_lim.size(); }
+
+		int add_clause(const std::vector<int>& literals, bool learned);
+		void enqueue(int lit, int reason);
+		int propagate();
+		void analyze(int conflict, std::vector<int>& learned, int& backtrack_level);
+		void cancel_until(int level);
+		void bump(int v);
+		int pick_branch_literal();
+		void reduce_db();
+		void relocate_all();
+
+		const generator_options& options;
+		std::mt19937_64 random;
+		std::ostream& out;
+
+		std::vector<generator_clause> clauses;
+		std::vector<std::vector<int> > watches;
+		int next_cref;
+
+		std::vector<int> assignment, level, reason, trail, trail_lim;
+		std::vector<bool> phase;
+		size_t qhead;
+
+		std::vector<double> activity;
+		double var_inc;
+		std::priority_queue<std::pair<double, int> > order;
+
+		// 0 = undecided, 1 = skip, 2 = keep in learned clause
+		std::vector<char> level_zero_policy;
+
+		long conflicts, reductions, since_restart, since_reduce;
+		generator_result stats;
+	};
+
+	int CdclGenerator::add_clause(const std::vector<int>& literals, bool learned)
+	{
+		generator_clause c;
+		c.literals = literals;
+		c.cref = next_cref;
+		c.learned = learned;
+		c.deleted = false;
+		next_cref += literals.size() + 2;
+
+		int index = clauses.size();
+		clauses.push_back(c);
+		if(literals.size() >= 2)
+		{
+			watches[negate(literals[0])].push_back(index);
+			watches[negate(literals[1])].push_back(index);
+		}
+
+		return index;
+	}
+
+	void CdclGenerator::enqueue(int lit, int why)
+	{
+		int v = var(lit);
+		assignment[v] = negated(lit) ? value_false : value_true;
+		level[v] = decision_level();
+		reason[v] = why;
+		trail.push_back(lit);
+	}
+
+	int CdclGenerator::propagate()
+	{
+		while(qhead < trail.size())
+		{
+			int p = trail[qhead++];
+			int false_lit = negate(p);
+			std::vector<int>& ws = watches[p];
+			size_t i = 0, j = 0;
+
+			while(i < ws.size())
+			{
+				int ci = ws[i++];
+				generator_clause& c = clauses[ci];
+				if(c.deleted) continue;
+
+				if(c.literals[0] == false_lit) std::swap(c.literals[0], c.literals[1]);
+				if(literal_value(c.literals[0]) == value_true)
+				{
+					ws[j++] = ci;
+					continue;
+				}
+
+				bool moved = false;
+				for(size_t k=2; k < c.literals.size(); k++)
+				{
+					if(literal_value(c.literals[k]) != value_false)
+					{
+						std::swap(c.literals[1], c.literals[k]);
+						watches[negate(c.literals[1])].push_back(ci);
+						moved = true;
+						break;
+					}
+				}
+				if(moved) continue;
+
+				ws[j++] = ci;
+				if(literal_value(c.literals[0]) == value_false)
+				{
+					while(i < ws.size()) ws[j++] = ws[i++];
+					ws.resize(j);
+					return ci;
+				}
+
+				enqueue(c.literals[0], ci);
+				out << "P ";
+				print_literal(c.literals[0]);
+				out << " " << c.cref << "\n";
+				stats.lines++;
+			}
+			ws.resize(j);
+		}
+
+		return -1;
+	}
+
+	void CdclGenerator::bump(int v)
+	{
+		activity[v] += var_inc;
+		if(activity[v] > 1e100)
+		{
+			for(double& a : activity) a *= 1e-100;
+			var_inc *= 1e-100;
+			order = std::priority_queue<std::pair<double, int> >();
+			for(size_t u=0; u < activity.size(); u++) order.push(std::make_pair(activity[u], u));
+		}
+		else if(assignment[v] == value_undef)
+		{
+			order.push(std::make_pair(activity[v], v));
+		}
+	}
+
+	void CdclGenerator::analyze(int conflict, std::vector<int>& learned, int& backtrack_level)
+	{
+		std::vector<bool> seen(assignment.size(), false);
+		std::vector<bool> kept(assignment.size(), false);
+		int path_count = 0;
+		int p = -1;
+		int index = trail.size() - 1;
+		learned.assign(1, -1);
+
+		do
+		{
+			assert(conflict >= 0);
+			const generator_clause& c = clauses[conflict];
+			out << "U " << c.cref << "\n";
+			stats.lines++;
+
+			std::vector<int> skipped;
+			for(int q : c.literals)
+			{
+				if(q == p) continue;
+				int v = var(q);
+
+				if(level[v] == 0)
+				{
+					// Literals that are false at level 0 are either skipped (and the
+					// shadow removes them using the level 0 units) or kept in the
+					// learned clause
+					char& policy = level_zero_policy[v];
+					if(policy == 0)
+					{
+						std::uniform_real_distribution<double> d(0, 1);
+						policy = d(random) < options.skip_density ? 1 : 2;
+					}
+					if(policy == 1)
+					{
+						skipped.push_back(q);
+					}
+					else if( ! kept[v])
+					{
+						kept[v] = true;
+						learned.push_back(q);
+					}
+					continue;
+				}
+
+				if( ! seen[v])
+				{
+					seen[v] = true;
+					bump(v);
+					if(level[v] >= decision_level()) path_count++;
+					else learned.push_back(q);
+				}
+			}
+
+			if( ! skipped.empty())
+			{
+				out << "S " << skipped.size();
+				for(int q : skipped)
+				{
+					out << " ";
+					print_literal(q);
+				}
+				out << "\n";
+				stats.lines++;
+			}
+
+			assert(path_count > 0);
+			while( ! seen[var(trail[index--])]);
+			p = trail[index + 1];
+			conflict = reason[var(p)];
+			seen[var(p)] = false;
+			path_count--;
+		} while(path_count > 0);
+
+		learned[0] = negate(p);
+
+		// Local minimization: a literal is redundant if all other literals of
+		// its reason are already in the learned clause
+		std::uniform_real_distribution<double> d(0, 1);
+		if(d(random) < options.minimize_rate)
+		{
+			std::vector<bool> in_learned(assignment.size(), false);
+			for(int q : learned) in_learned[var(q)] = true;
+
+			std::vector<int> minimized(1, learned[0]);
+			std::vector<int> removed;
+			for(size_t i=1; i < learned.size(); i++)
+			{
+				int v = var(learned[i]);
+				bool redundant = level[v] > 0 && reason[v] >= 0;
+				if(redundant)
+				{
+					for(int q : clauses[reason[v]].literals)
+					{
+						if(var(q) != v && ! in_learned[var(q)])
+						{
+							redundant = false;
+							break;
+						}
+					}
+				}
+
+				if(redundant) removed.push_back(learned[i]);
+				else minimized.push_back(learned[i]);
+			}
+
+			if( ! removed.empty())
+			{
+				out << "MNM " << removed.size();
+				for(int q : removed)
+				{
+					out << " ";
+					print_literal(q);
+				}
+				out << "\n";
+				stats.lines++;
+				learned.swap(minimized);
+			}
+		}
+
+		// Put the literal with the highest level second, so that it is watched
+		backtrack_level = 0;
+		for(size_t i=1; i < learned.size(); i++)
+		{
+			if(level[var(learned[i])] > backtrack_level)
+			{
+				backtrack_level = level[var(learned[i])];
+				std::swap(learned[1], learned[i]);
+			}
+		}
+	}
+
+	void CdclGenerator::cancel_until(int to_level)
+	{
+		if(decision_level() <= to_level) return;
+
+		for(int i=trail.size() - 1; i >= trail_lim[to_level]; i--)
+		{
+			int v = var(trail[i]);
+			assignment[v] = value_undef;
+			phase[v] = negated(trail[i]);
+			order.push(std::make_pair(activity[v], v));
+		}
+
+		trail.resize(trail_lim[to_level]);
+		trail_lim.resize(to_level);
+		qhead = trail.size();
+	}
+
+	int CdclGenerator::pick_branch_literal()
+	{
+		while( ! order.empty())
+		{
+			std::pair<double, int> top = order.top();order.pop();
+			int v = top.second;
+			if(assignment[v] != value_undef || top.first != activity[v]) continue;
+			return 2 * v + (phase[v] ? 1 : 0);
+		}
+
+		// Stale heap entries may hide unassigned variables
+		for(size_t v=0; v < assignment.size(); v++)
+		{
+			if(assignment[v] == value_undef) return 2 * v + (phase[v] ? 1 : 0);
+		}
+
+		return -1;
+	}
+
+	void CdclGenerator::reduce_db()
+	{
+		std::uniform_real_distribution<double> d(0, 1);
+
+		for(size_t i=0; i < clauses.size(); i++)
+		{
+			generator_clause& c = clauses[i];
+			if( ! c.learned || c.deleted) continue;
+
+			int first = c.literals[0];
+			bool locked = literal_value(first) == value_true && reason[var(first)] == (int) i;
+			if(locked || d(random) < options.learn_keep) continue;
+
+			c.deleted = true;
+			out << "R " << c.cref << "\n";
+			stats.lines++;
+		}
+
+		reductions++;
+		if(options.gc_interval > 0 && reductions % options.gc_interval == 0) relocate_all();
+	}
+
+	// Compact the clause arena the way minisat's garbage collector does, which
+	// gives every live clause a new cref
+	void CdclGenerator::relocate_all()
+	{
+		int cref = 0;
+		for(generator_clause& c : clauses)
+		{
+			if(c.deleted || c.literals.size() < 2) continue;
+			if(c.cref != cref)
+			{
+				out << "M " << c.cref << " " << cref << "\n";
+				stats.lines++;
+			}
+			c.cref = cref;
+			cref += c.literals.size() + 2;
+		}
+		next_cref = cref;
+
+		out << "RD\n";
+		stats.lines++;
+		stats.relocations++;
+	}
+
+	bool CdclGenerator::run(generator_result& result)
+	{
+		int n = options.num_vars;
+		watches.resize(2 * n);
+		assignment.assign(n, value_undef);
+		level.assign(n, 0);
+		reason.assign(n, reason_decision);
+		phase.assign(n, false);
+		activity.assign(n, 0);
+		level_zero_policy.assign(n, 0);
+
+		std::uniform_int_distribution<int> pick_var(0, n - 1);
+		std::uniform_int_distribution<int> pick_sign(0, 1);
+		for(int v=0; v < n; v++)
+		{
+			order.push(std::make_pair(0.0, v));
+			phase[v] = pick_sign(random);
+		}
+
+		out << "NV " << n << "\n";
+		stats.lines++;
+
+		long num_clauses = (long) (options.ratio * n);
+		for(long i=0; i < num_clauses; i++)
+		{
+			std::vector<int> literals;
+			while((int) literals.size() < options.clause_width)
+			{
+				int v = pick_var(random);
+				bool duplicate = false;
+				for(int lit : literals) if(var(lit) == v) duplicate = true;
+				if( ! duplicate) literals.push_back(2 * v + pick_sign(random));
+			}
+
+			int index = add_clause(literals, false);
+			out << "I ";
+			print_clause(clauses[index].cref, literals);
+			out << "\n";
+			stats.lines++;
+		}
+
+		while(conflicts < options.max_conflicts)
+		{
+			int conflict = propagate();
+
+			if(conflict >= 0)
+			{
+				if(decision_level() == 0)
+				{
+					out << "C " << clauses[conflict].cref << "\n";
+					stats.lines++;
+					stats.conflicts = conflicts;
+					result = stats;
+					return true;
+				}
+
+				conflicts++;
+				since_restart++;
+				since_reduce++;
+
+				std::vector<int> learned;
+				int backtrack_level;
+				analyze(conflict, learned, backtrack_level);
+
+				out << "B " << backtrack_level << "\n";
+				stats.lines++;
+				cancel_until(backtrack_level);
+
+				if(learned.size() == 1)
+				{
+					out << "LU ";
+					print_literal(learned[0]);
+					out << "\n";
+					enqueue(learned[0], reason_unit);
+					out << "PU ";
+					print_literal(learned[0]);
+					out << "\n";
+					stats.lines += 2;
+				}
+				else
+				{
+					int index = add_clause(learned, true);
+					out << "L ";
+					print_clause(clauses[index].cref, learned);
+					out << "\n";
+					enqueue(learned[0], index);
+					out << "P ";
+					print_literal(learned[0]);
+					out << " " << clauses[index].cref << "\n";
+					stats.lines += 2;
+				}
+
+				var_inc /= 0.95;
+				continue;
+			}
+
+			if(options.restart_interval > 0 && since_restart >= options.restart_interval)
+			{
+				since_restart = 0;
+				out << "RS\n";
+				stats.lines++;
+				stats.restarts++;
+				cancel_until(0);
+			}
+
+			if(options.reduce_interval > 0 && since_reduce >= options.reduce_interval)
+			{
+				since_reduce = 0;
+				reduce_db();
+			}
+
+			int next = pick_branch_literal();
+			if(next == -1) return false;
+
+			trail_lim.push_back(trail.size());
+			enqueue(next, reason_decision);
+			out << "D ";
+			print_literal(next);
+			out << "\n";
+			stats.lines++;
+		}
+
+		return false;
+	}
+}
+
+generator_result generate_trace(const generator_options& options, std::ostream& out)
+{
+	generator_result result;
+
+	for(uint64_t seed = options.seed; ; seed++)
+	{
+		std::ostringstream buffer;
+		CdclGenerator generator(options, seed, buffer);
+
+		if(generator.run(result))
+		{
+			result.seed = seed;
+			out << buffer.str();
+			return result;
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <ostream>
+#include <cstdint>
+
+// Parameters for the synthetic trace generator. The generator runs a small
+// CDCL solver on a random k-SAT instance and prints the same trace format
+// as the instrumented minisat, so all traces it produces can be replayed by
+// ResolutionGraph in every ignore mode
+struct generator_options
+{
+	int num_vars = 120;
+	int clause_width = 3;
+	// Input clauses per variable (above ~4.3 random 3-SAT is almost always
+	// unsatisfiable)
+	double ratio = 5.0;
+	uint64_t seed = 1;
+
+	// Conflicts between restarts (RS), 0 disables restarts
+	int restart_interval = 100;
+	// Conflicts between learned clause database reductions (R), 0 disables them
+	int reduce_interval = 300;
+	// Fraction of unlocked learned clauses kept at each reduction
+	double learn_keep = 0.5;
+	// Reductions between garbage collections (M/RD), 0 disables relocation
+	int gc_interval = 2;
+	// Probability that a literal assigned at level 0 is skipped (S) during
+	// conflict analysis instead of being kept in the learned clause
+	double skip_density = 1.0;
+	// Probability that redundant literals are removed with an MNM step
+	double minimize_rate = 0.5;
+
+	// Give up (and try the next seed) after this many conflicts
+	long max_conflicts = 2000000;
+};
+
+struct generator_result
+{
+	long lines = 0, conflicts = 0, restarts = 0, relocations = 0;
+	uint64_t seed = 0;
+};
+
+// Writes a complete trace ending in a final conflict (C). Instances that turn
+// out to be satisfiable are discarded and retried with the next seed
+generator_result generate_trace(const generator_options& options, std::ostream& out);
@@ -0,0 +1,283 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include "literal.hpp"
+#include "clause.hpp"
+#include "solver_shadow.hpp"
+#include "resolution_graph.hpp"
+#include "proof_events.hpp"
+#include "trace_reader.hpp"
+#include "proof_dag.hpp"
+#include "dot_writer.hpp"
+#include "trace_generator.hpp"
+
+// Differential validation: every engine replays the same traces in every
+// ignore mode and has to produce the same statistics and the same proof DAG
+// as the reference engine, the plain replay that ResolutionGraph runs by
+// default. Prints one JSON line per trace, mode and engine with its timing
+// relative to the reference, and exits with 1 on any mismatch
+//
+// New engines (alternative clause storage, parallel replay, ...) are added
+// to the engines table below. Engines that reclaim removed clauses drop part
+// of the unused DAG on purpose, and are only compared on the used part
+
+namespace
+{
+	struct engine_result
+	{
+		std::string statistics;
+		uint64_t shape;
+		// Without the unused statistics and the unused part of the DAG
+		std::string used_statistics;
+		uint64_t used_shape;
+		double seconds;
+	};
+
+	// FNV-1a over the nodes of the whole DAG (used and unused), their parents
+	// and their literals in sorted order, so that engines may store the
+	// literals of a clause in any order
+	uint64_t dag_shape(const ProofDag& dag)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		auto mix = [&hash](long long value)
+		{
+			hash ^= (uint64_t) value;
+			hash *= 1099511628211ULL;
+		};
+
+		for(size_t i=0; i < dag.size(); i++)
+		{
+			const dag_node& node = dag.nodes()[i];
+			mix(dag.used(i));
+			mix(node.first);
+			mix(node.second);
+
+			std::vector<long long> literals;
+			for(const Literal& l : node.clause->literals()) literals.push_back(2LL * l.variable() + l.negated());
+			std::sort(literals.begin(), literals.end());
+			mix(literals.size());
+			for(long long l : literals) mix(l);
+		}
+
+		return hash;
+	}
+
+	// How an engine replays the trace
+	struct replay_options
+	{
+		bool build_graph = false;
+		bool stream_dot = false;
+		// Decoding on tokenizer threads, in chunks of chunk_size bytes
+		int threads = 1;
+		size_t chunk_size = 1 << 22;
+		// See SolverShadowBase::compact_clauses and reclaim_removed
+		bool compact_clauses = false;
+		bool reclaim_removed = false;
+	};
+
+	// Replays the trace and builds the statistics the way main does, with
+	// either the Boost graph or the streaming GraphViz writer
+	template<ignore_mode mode>
+	engine_result replay(const std::string& trace, const replay_options& options)
+	{
+		engine_result result;
+		auto start = std::chrono::steady_clock::now();
+
+		std::istringstream input(trace);
+		ProofEvents<mode> events;
+		events.compact_clauses(options.compact_clauses);
+		events.reclaim_removed(options.reclaim_removed);
+		TraceReader<mode> reader(input, events, false);
+		reader.tokenize_in_parallel(options.threads, options.chunk_size);
+		int ref = -1;
+		if( ! reader.read_until_conflict(ref))
+		{
+			result.shape = 0;
+			result.used_shape = 0;
+			result.seconds = 0;
+			return result;
+		}
+
+		std::ostringstream graphviz;
+		std::unique_ptr<DotWriter> dot;
+		if(options.stream_dot) dot.reset(new DotWriter(graphviz, true));
+
+		ResolutionGraph graph = events.on_final_conflict(ref, options.build_graph, dot.get());
+		dot.reset();
+
+		std::ostringstream all_statistics;
+		write_statistics(all_statistics, graph.vertex_statistics());
+		result.statistics = all_statistics.str();
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		statistics used = graph.vertex_statistics();
+		used.passes &= ~pass_unused;
+		std::ostringstream used_statistics;
+		write_statistics(used_statistics, used);
+		result.used_statistics = used_statistics.str();
+
+		ProofDag dag(graph.refutation());
+		result.used_shape = dag_shape(dag);
+		dag.add_unused(events.shadow());
+		result.shape = dag_shape(dag);
+		return result;
+	}
+
+	template<ignore_mode mode>
+	engine_result reference(const std::string& trace)
+	{
+		return replay<mode>(trace, replay_options());
+	}
+
+	template<ignore_mode mode>
+	engine_result boost_graph(const std::string& trace)
+	{
+		replay_options options;
+		options.build_graph = true;
+		return replay<mode>(trace, options);
+	}
+
+	template<ignore_mode mode>
+	engine_result streaming_dot(const std::string& trace)
+	{
+		replay_options options;
+		options.stream_dot = true;
+		return replay<mode>(trace, options);
+	}
+
+	// Chunks of a few lines, so that many cuts fall next to U and S lines
+	template<ignore_mode mode>
+	engine_result parallel_tokenizer(const std::string& trace)
+	{
+		replay_options options;
+		options.threads = 3;
+		options.chunk_size = 64;
+		return replay<mode>(trace, options);
+	}
+
+	// Compact literals, and reclaimed clauses that let relocations drop
+	// entries from the clause list
+	template<ignore_mode mode>
+	engine_result compact_clauses(const std::string& trace)
+	{
+		replay_options options;
+		options.compact_clauses = true;
+		options.reclaim_removed = true;
+		return replay<mode>(trace, options);
+	}
+
+	typedef engine_result (*engine_function)(const std::string& trace);
+
+	// One instantiation per ignore mode
+	struct engine
+	{
+		const char* name;
+		engine_function run[3];
+		bool used_only;
+	};
+
+	const engine engines[] = {
+		{"reference", {reference<none>, reference<learn>, reference<resolve_unit>}, false},
+		{"boost_graph", {boost_graph<none>, boost_graph<learn>, boost_graph<resolve_unit>}, false},
+		{"streaming_dot", {streaming_dot<none>, streaming_dot<learn>, streaming_dot<resolve_unit>}, false},
+		{"parallel_tokenizer", {parallel_tokenizer<none>, parallel_tokenizer<learn>, parallel_tokenizer<resolve_unit>}, false},
+		{"compact_clauses", {compact_clauses<none>, compact_clauses<learn>, compact_clauses<resolve_unit>}, true},
+	};
+
+	struct named_trace
+	{
+		std::string name;
+		std::string contents;
+	};
+
+	// Small traces that cover skipped literals, restarts, removals and
+	// relocations
+	std::vector<named_trace> generated_traces(int count)
+	{
+		std::vector<named_trace> traces;
+		for(int i=0; i < count; i++)
+		{
+			generator_options options;
+			options.num_vars = 60 + 20 * i;
+			options.seed = i + 1;
+			options.skip_density = i % 3 == 0 ? 1.0 : (i % 3 == 1 ? 0.5 : 0.0);
+
+			std::ostringstream trace;
+			generate_trace(options, trace);
+			traces.push_back(named_trace{"generated_" + std::to_string(i), trace.str()});
+		}
+		return traces;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int num_generated = 3;
+	std::vector<std::string> files;
+
+	boost::program_options::options_description desc("Supported options");
+	desc.add_options()
+		("help", "show this help")
+		("generated", boost::program_options::value<int>(&num_generated), "number of generated traces to validate on (default 3)")
+		("trace", boost::program_options::value<std::vector<std::string> >(&files), "recorded trace to validate on, may be repeated")
+	;
+
+	boost::program_options::positional_options_description positional;
+	positional.add("trace", -1);
+
+	boost::program_options::variables_map vm;
+	boost::program_options::store(boost::program_options::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+	boost::program_options::notify(vm);
+
+	if (vm.count("help"))
+	{
+		std::cout << desc << "\n";
+		return 1;
+	}
+
+	std::vector<named_trace> traces = generated_traces(num_generated);
+	for(const std::string& file : files)
+	{
+		std::ifstream in(file);
+		if( ! in)
+		{
+			std::cout << "ERROR: Could not open " << file << std::endl;
+			return 1;
+		}
+		std::ostringstream contents;
+		contents << in.rdbuf();
+		traces.push_back(named_trace{file, contents.str()});
+	}
+
+	int runs = 0, mismatches = 0;
+	for(const named_trace& trace : traces)
+	{
+		for(int mode=0; mode < 3; mode++)
+		{
+			engine_result expected = engines[0].run[mode](trace.contents);
+
+			for(const engine& e : engines)
+			{
+				engine_result result = &e == &engines[0] ? expected : e.run[mode](trace.contents);
+				bool statistics_match = e.used_only ? result.used_statistics == expected.used_statistics : result.statistics == expected.statistics;
+				bool shape_match = e.used_only ? result.used_shape == expected.used_shape : result.shape == expected.shape;
+
+				runs++;
+				if( ! statistics_match || ! shape_match) mismatches++;
+
+				std::cout << "{\"trace\": \"" << trace.name << "\", \"mode\": " << mode << ", \"engine\": \"" << e.name
+					<< "\", \"seconds\": " << result.seconds << ", \"relative_time\": " << (expected.seconds > 0 ? result.seconds / expected.seconds : 0)
+					<< ", \"statistics_match\": " << (statistics_match ? "true" : "false")
+					<< ", \"shape_match\": " << (shape_match ? "true" : "false") << "}" << std::endl;
+			}
+		}
+	}
+
+	std::cout << "{\"runs\": " << runs << ", \"mismatches\": " << mismatches << "}" << std::endl;
+	return mismatches > 0 ? 1 : 0;
+}
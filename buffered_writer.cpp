@@ -0,0 +1,74 @@
+#include "buffered_writer.hpp"
+#include <charconv>
+#include <cstring>
+
+BufferedWriter::BufferedWriter(std::ostream& _out, size_t buffer_size) : out(_out), buffer(buffer_size), used(0)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+	flush();
+}
+
+void BufferedWriter::write(const char* data, size_t length)
+{
+	if(used + length > buffer.size())
+	{
+		drain();
+
+		// Too large to be worth buffering
+		if(length > buffer.size())
+		{
+			out.write(data, length);
+			return;
+		}
+	}
+
+	std::memcpy(buffer.data() + used, data, length);
+	used += length;
+}
+
+BufferedWriter& BufferedWriter::operator<<(const std::string& s)
+{
+	write(s.data(), s.size());
+	return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(const char* s)
+{
+	write(s, std::strlen(s));
+	return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(char c)
+{
+	if(used == buffer.size()) drain();
+	buffer[used++] = c;
+	return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(long long value)
+{
+	char digits[24];
+	std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+	write(digits, result.ptr - digits);
+	return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(int value)
+{
+	return *this << (long long) value;
+}
+
+void BufferedWriter::drain()
+{
+	if(used > 0) out.write(buffer.data(), used);
+	used = 0;
+}
+
+void BufferedWriter::flush()
+{
+	drain();
+	out.flush();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+// BufferedWriter collects output in a large buffer and hands it to the
+// underlying stream in big blocks, which keeps writing huge outputs (graphs,
+// proofs) from being dominated by per-call stream overhead
+class BufferedWriter
+{
+public:
+	BufferedWriter(std::ostream& _out, size_t buffer_size = 1 << 20);
+	~BufferedWriter();
+
+	BufferedWriter& operator<<(const std::string& s);
+	BufferedWriter& operator<<(const char* s);
+	BufferedWriter& operator<<(char c);
+	BufferedWriter& operator<<(long long value);
+	BufferedWriter& operator<<(int value);
+	void write(const char* data, size_t length);
+	void flush();
+
+private:
+	void drain();
+
+	std::ostream& out;
+	std::vector<char> buffer;
+	size_t used;
+};
@@ -1,7 +1,75 @@
 #include "clause.hpp"
+#include "profiler.hpp"
+#include "histograms.hpp"
 #include <map>
 #include <algorithm>
 
+namespace
+{
+	void put_varint(unsigned char*& p, unsigned int value)
+	{
+		while(value >= 0x80)
+		{
+			*p++ = (unsigned char) ((value & 0x7f) | 0x80);
+			value >>= 7;
+		}
+		*p++ = (unsigned char) value;
+	}
+
+	unsigned int get_varint(const unsigned char*& p)
+	{
+		unsigned int value = 0;
+		for(int shift=0; ; shift += 7)
+		{
+			unsigned char byte = *p++;
+			value |= (unsigned int) (byte & 0x7f) << shift;
+			if((byte & 0x80) == 0) return value;
+		}
+	}
+
+	// The width, the deltas between the sorted variables (the first from 0)
+	// and then one sign bit per literal
+	std::unique_ptr<unsigned char[]> encode_literals(const std::vector<Literal>& literals)
+	{
+		size_t width = literals.size();
+		std::unique_ptr<unsigned char[]> buffer(new unsigned char[5 * (width + 1) + (width + 7) / 8]);
+		unsigned char* p = buffer.get();
+
+		put_varint(p, width);
+		int previous = 0;
+		for(const Literal& l : literals)
+		{
+			put_varint(p, l.variable() - previous);
+			previous = l.variable();
+		}
+
+		std::fill(p, p + (width + 7) / 8, 0);
+		for(size_t i=0; i < width; i++)
+		{
+			if(literals[i].negated()) p[i / 8] |= 1 << (i % 8);
+		}
+		p += (width + 7) / 8;
+
+		// Only keep what the encoding needs
+		std::unique_ptr<unsigned char[]> encoded(new unsigned char[p - buffer.get()]);
+		std::copy(buffer.get(), p, encoded.get());
+		return encoded;
+	}
+
+	std::vector<Literal> decode_literals(const unsigned char* p)
+	{
+		size_t width = get_varint(p);
+		std::vector<int> variables(width);
+		int variable = 0;
+		for(int& v : variables) v = variable += get_varint(p);
+
+		std::vector<Literal> literals;
+		literals.reserve(width);
+		for(size_t i=0; i < width; i++) literals.push_back(Literal(variables[i], (p[i / 8] >> (i % 8)) & 1));
+		return literals;
+	}
+}
+
 Clause::Clause(std::vector<Literal> literals)
 {
 	this->literal_vector = literals;
@@ -12,20 +80,29 @@ Clause::Clause(std::vector<Literal> literals)
 	);
 
 	this->learned = false;
-	this->removed_var = boost::none;
+	this->removed_var = -1;
 
 	this->_violated_regularity = false;
+	this->recently_resolved = false;
+	this->mark = 0;
+	this->ordinal = 0;
+	this->literal_fingerprint = fingerprint(this->literal_vector);
 
-	// An axiom clause has no parents, and so copying it costs 1
-	this->cost = 1;
+	account_memory(1);
 }
 
-Clause::Clause(std::vector<Literal> literals, const std::pair<std::shared_ptr<const Clause>, std::shared_ptr<const Clause> > source, int removed) : Clause(literals)
+Clause::Clause(std::vector<Literal> literals, const std::pair<std::shared_ptr<const Clause>, std::shared_ptr<const Clause> > source, int removed, uint64_t fingerprint)
 {
+	this->literal_vector = literals;
+	this->literal_fingerprint = fingerprint;
+
 	this->parents = source;
 	this->learned = false;
 	this->removed_var = removed;
 	this->_violated_regularity = false;
+	this->recently_resolved = false;
+	this->mark = 0;
+	this->ordinal = 0;
 
 	this->removed_variables = source.first->removed_variables;
 	const std::vector<bool>& other_removed = source.second->removed_variables;
@@ -43,8 +120,7 @@ Clause::Clause(std::vector<Literal> literals, const std::pair<std::shared_ptr<co
 	}
 	this->removed_variables[removed] = true;
 
-	// An intermediate clause costs 1 to copy itself, plus whatever the parents cost
-	this->cost = 1 + source.first->cost + source.second->cost;
+	account_memory(1);
 }
 
 Clause::Clause(const Clause& other)
@@ -55,22 +131,46 @@ Clause::Clause(const Clause& other)
 	this->learned = other.learned;
 	this->removed_var = other.removed_var;
 	this->removed_variables = other.removed_variables;
-	this->cost = other.cost;
+	this->literal_fingerprint = other.literal_fingerprint;
 	this->_violated_regularity = other._violated_regularity;
 	this->_violated_regularity_variable = other._violated_regularity_variable;
+	this->recently_resolved = false;
+	// A copy is a different node of the DAG, which no refutation reached yet
+	this->mark = 0;
+	this->ordinal = other.ordinal;
+
+	account_memory(1);
 }
 
-Clause::Clause(const Clause& other, bool is_learned) : Clause(other)
+Clause::Clause(const Clause& other, bool is_learned, int ordinal) : Clause(other)
 {
+	account_memory(-1);
 	this->learned = is_learned;
+	this->ordinal = ordinal;
 	assert(this->is_resolvent());
+	account_memory(1);
+}
+
+Clause::~Clause()
+{
+	account_memory(-1);
+}
+
+void Clause::account_memory(long long sign) const
+{
+	memory_category category = memory_intermediate;
+	if(is_axiom()) category = memory_axioms;
+	else if(is_learned()) category = memory_learned;
+
+	memory_add(category, sign * (long long) (sizeof(Clause) + literal_vector.capacity() * sizeof(Literal) + compact_size()));
+	memory_add(memory_removed_variables, sign * (long long) (removed_variables.capacity() / 8));
 }
 
 std::string const Clause::to_str() const
 {
 	std::string out;
 
-	for(const Literal& l : literal_vector)
+	for(const Literal& l : literals())
 	{
 		out += l.to_str() + " ";
 	}
@@ -80,6 +180,9 @@ std::string const Clause::to_str() const
 
 std::shared_ptr<const Clause> Clause::resolve(const std::shared_ptr<const Clause>& clause, const std::shared_ptr<const Clause>& other)
 {
+	PROFILE_COUNT(counter_resolutions, 1);
+	clause->expand();
+	other->expand();
 	const std::vector<Literal>& lits1 = clause->literals();
 	const std::vector<Literal>& lits2 = other->literals();
 	auto it1 = lits1.begin();
@@ -87,6 +190,10 @@ std::shared_ptr<const Clause> Clause::resolve(const std::shared_ptr<const Clause
 	std::vector<Literal> out;
 	boost::optional<int> removed;
 
+	// Literals present in both clauses, and the clashing pair, are in the sum
+	// of the parents' fingerprints once too often
+	uint64_t sum = clause->fingerprint() + other->fingerprint();
+
 	while(it1 != lits1.end() && it2 != lits2.end())
 	{
 		if(it1->variable() < it2->variable())
@@ -104,11 +211,13 @@ std::shared_ptr<const Clause> Clause::resolve(const std::shared_ptr<const Clause
 			if(*it1 == *it2)
 			{
 				out.push_back(*it1);
+				sum -= fingerprint(*it1);
 			}
 			else
 			{
 				assert(removed == boost::none);
 				removed = it1->variable();
+				sum -= fingerprint(*it1) + fingerprint(*it2);
 			}
 
 			it1++;
@@ -128,8 +237,9 @@ std::shared_ptr<const Clause> Clause::resolve(const std::shared_ptr<const Clause
 	}
 
 	assert(removed != boost::none);
-	
-	return std::make_shared<Clause>(Clause(out, std::make_pair(clause, other), removed.value()));
+	if(histograms_active) histogram_add(histogram_resolvent_width, out.size());
+
+	return std::make_shared<Clause>(Clause(out, std::make_pair(clause, other), removed.value(), sum));
 }
 
 std::shared_ptr<const Clause> Clause::resolve(const std::vector<std::shared_ptr<const Clause> > clauses)
@@ -145,33 +255,33 @@ std::shared_ptr<const Clause> Clause::resolve(const std::vector<std::shared_ptr<
 
 bool Clause::unit() const
 {
-	return literal_vector.size() == 1;
+	return width() == 1;
 }
 
 Literal Clause::first_literal() const
 {
+	if(compact_literals != nullptr) return decode_literals(compact_literals.get())[0];
 	return literal_vector[0];
 }
 
 bool Clause::operator==(const Clause& other) const
 {
-	if(literal_vector.size() != other.literals().size()) return false;
-
-	for(size_t i=0; i < literal_vector.size(); i++)
-	{
-		if(literal_vector[i] != other.literals()[i]) return false;
-	}
-
-	return true;
+	return literals() == other.literals();
 }
 
 std::vector<Literal> Clause::literals() const
 {
+	if(compact_literals != nullptr) return decode_literals(compact_literals.get());
 	return std::vector<Literal>(this->literal_vector);
 }
 
 int Clause::width() const
 {
+	if(compact_literals != nullptr)
+	{
+		const unsigned char* p = compact_literals.get();
+		return get_varint(p);
+	}
 	return this->literal_vector.size();
 }
 
@@ -187,7 +297,7 @@ bool Clause::is_resolvent() const
 
 bool Clause::empty() const
 {
-	return this->literals().size() == 0;
+	return width() == 0;
 }
 
 bool Clause::is_learned() const
@@ -197,7 +307,9 @@ bool Clause::is_learned() const
 
 void Clause::is_learned(bool l)
 {
+	account_memory(-1);
 	this->learned = l;
+	account_memory(1);
 }
 
 bool Clause::is_axiom() const
@@ -212,12 +324,29 @@ std::ostream & operator<<(std::ostream &os, const Clause& c)
 
 boost::optional<int> Clause::removed_variable() const
 {
+	if(this->removed_var == -1) return boost::none;
 	return this->removed_var;
 }
 
-long double Clause::copy_cost() const
+uint64_t Clause::fingerprint() const
 {
-	return this->cost;
+	return this->literal_fingerprint;
+}
+
+uint64_t Clause::fingerprint(const std::vector<Literal>& literals)
+{
+	uint64_t sum = 0;
+	for(const Literal& l : literals) sum += fingerprint(l);
+	return sum;
+}
+
+// splitmix64 of the literal's code
+uint64_t Clause::fingerprint(const Literal& l)
+{
+	uint64_t z = 2 * (uint64_t) l.variable() + l.negated() + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
 }
 
 bool Clause::violated_regularity() const
@@ -229,3 +358,59 @@ long Clause::violated_regularity_variable() const
 {
 	return this->_violated_regularity_variable;
 }
+
+int Clause::learned_ordinal() const
+{
+	return this->ordinal;
+}
+
+int Clause::refutation_mark() const
+{
+	return this->mark;
+}
+
+void Clause::mark_refutation(int refutation) const
+{
+	this->mark = refutation;
+}
+
+void Clause::compact_if_cold() const
+{
+	if(recently_resolved)
+	{
+		recently_resolved = false;
+		return;
+	}
+	if(compact_literals != nullptr || literal_vector.empty()) return;
+
+	account_memory(-1);
+	compact_literals = encode_literals(literal_vector);
+	std::vector<Literal>().swap(literal_vector);
+	account_memory(1);
+}
+
+bool Clause::compacted() const
+{
+	return compact_literals != nullptr;
+}
+
+void Clause::expand() const
+{
+	recently_resolved = true;
+	if(compact_literals == nullptr) return;
+
+	account_memory(-1);
+	literal_vector = decode_literals(compact_literals.get());
+	compact_literals.reset();
+	account_memory(1);
+}
+
+size_t Clause::compact_size() const
+{
+	if(compact_literals == nullptr) return 0;
+
+	const unsigned char* p = compact_literals.get();
+	size_t width = get_varint(p);
+	for(size_t i=0; i < width; i++) get_varint(p);
+	return p - compact_literals.get() + (width + 7) / 8;
+}
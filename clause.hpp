@@ -1,9 +1,11 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 #include <algorithm>
 #include <utility>
 #include <boost/optional.hpp>
 #include "literal.hpp"
+#include "memory_accounting.hpp"
 
 #include <memory>
 
@@ -11,11 +13,15 @@ class Clause
 {
 public:
 	Clause(std::vector<Literal> literals);
-	Clause(std::vector<Literal> literals, const std::pair<std::shared_ptr<const Clause>, std::shared_ptr<const Clause> > source, int removed);
+	// Resolvent of source on removed. The literals have to be sorted already
+	// and fingerprint has to be their fingerprint (see resolve)
+	Clause(std::vector<Literal> literals, const std::pair<std::shared_ptr<const Clause>, std::shared_ptr<const Clause> > source, int removed, uint64_t fingerprint);
 	Clause(const Clause& other);
+	~Clause();
 
 	// Separate copy constructor for modifying is_learned (allows for const everywhere else)
-	Clause(const Clause& other, bool is_learned);
+	// and numbering learned clauses
+	Clause(const Clause& other, bool is_learned, int ordinal);
 	std::string const to_str() const;
 	bool unit() const; 
 	Literal first_literal() const;
@@ -28,26 +34,64 @@ public:
 	bool is_learned() const;
 	void is_learned(bool l);
 	bool is_axiom() const;
+	// Learned clauses are numbered from 1 in the order they are learned, 0
+	// for any other clause
+	int learned_ordinal() const;
 	boost::optional<int> removed_variable() const;
 	long double num_regularity_violations() const;
 	std::vector<int> regularity_violation_variables() const;
-	long double copy_cost() const;
+
+	// Order independent hash of the set of literals, the sum of a hash per
+	// literal, so that a resolvent's fingerprint follows from its parents'
+	uint64_t fingerprint() const;
+	static uint64_t fingerprint(const std::vector<Literal>& literals);
+	static uint64_t fingerprint(const Literal& l);
 
 	static std::shared_ptr<const Clause> resolve(const std::shared_ptr<const Clause>& clause, const std::shared_ptr<const Clause>& other);
 	static std::shared_ptr<const Clause> resolve(const std::vector<std::shared_ptr<const Clause> > clauses);
 
 	bool violated_regularity() const;
 	long violated_regularity_variable() const;
+
+	// The refutation (numbered from 1) whose used proof first reached this
+	// clause, or minus the refutation whose unused traversal did, 0 if none
+	// did yet. Kept in the clause itself, so that with several refutations
+	// every traversal can stop at what an earlier one classified
+	int refutation_mark() const;
+	void mark_refutation(int refutation) const;
+
+	// A cold clause can be compacted: its literals are then kept as varints of
+	// the deltas between the sorted variables, followed by a bitmap of the
+	// signs, a fraction of their vector. Everything that reads the literals
+	// decodes them transparently, and resolving the clause expands it again.
+	// compact_if_cold compacts the clause unless it was resolved since the
+	// previous call
+	void compact_if_cold() const;
+	bool compacted() const;
 private:
-	std::vector<Literal> literal_vector;
+	// Adds (sign 1) or removes (sign -1) the memory held by this clause
+	// to the memory accounting of its kind
+	void account_memory(long long sign) const;
+
+	void expand() const;
+	size_t compact_size() const;
+
+	// Empty while the clause is compacted
+	mutable std::vector<Literal> literal_vector;
+	mutable std::unique_ptr<unsigned char[]> compact_literals;
 	friend std::ostream & operator<<(std::ostream &os, const Clause& c);
 	std::pair<std::shared_ptr<const Clause>, std::shared_ptr<const Clause> > parents;
 	bool learned;
-	boost::optional<int> removed_var;
+	bool _violated_regularity;
+	mutable bool recently_resolved;
+	// -1 if the clause is not a resolvent. Together with the flags before it,
+	// removed_var, ordinal and mark fill 16 bytes
+	int removed_var;
+	int ordinal;
+	mutable int mark;
 	std::vector<bool> removed_variables;
 
-	long double cost;
+	uint64_t literal_fingerprint;
 
-	bool _violated_regularity;
 	long _violated_regularity_variable;
 };
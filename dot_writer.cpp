@@ -0,0 +1,150 @@
+#include "dot_writer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+DotWriter::DotWriter(std::ostream& out, bool _include_unused, bool _summarize) :
+	writer(out), include_unused(_include_unused), summarize(_summarize), current(-1), current_position{-1, 0}
+{
+	writer << "digraph G {\n";
+}
+
+DotWriter::~DotWriter()
+{
+	if(summarize)
+	{
+		finish_current();
+		// Derivations left open reach clauses the traversal skipped
+		while( ! open.empty()) finish(open.begin()->first);
+	}
+
+	writer << "}\n";
+}
+
+void DotWriter::node(int index, const Clause& clause, bool used)
+{
+	if( ! used && ! include_unused) return;
+
+	if(summarize) summary_node(index, clause, used);
+	else write_node(index, clause, used, "");
+}
+
+void DotWriter::edge(int from, int to, const Clause& resolvent, bool used)
+{
+	if( ! used && ! include_unused) return;
+
+	if(summarize) summary_edge(from, to);
+	else writer << from << "->" << to << " [label=\"" << resolvent.removed_variable().value() << "\"];\n";
+}
+
+bool DotWriter::includes_unused() const
+{
+	return include_unused;
+}
+
+void DotWriter::write_node(int index, const Clause& clause, bool used, const std::string& extra_label)
+{
+	writer << index << "[label=\"" << clause.to_str() << extra_label << "\"]";
+	if(clause.is_axiom()) writer << " [style=filled]";
+	else if(clause.is_learned()) writer << " [style=filled] [fillcolor=turquoise1]";
+
+	if( ! used) writer << " [fontsize=6] [width=0.25] [height=0.25]";
+	writer << ";\n";
+}
+
+void DotWriter::summary_node(int index, const Clause& clause, bool used)
+{
+	// The edges of the previous node have all been written
+	finish_current();
+
+	// Roots of the traversal (the refutation and unused learned clauses)
+	// were not queued by any derivation
+	auto it = queued.find(index);
+	bool root = it == queued.end();
+	position at = root ? position{-1, 0} : it->second;
+	if( ! root) queued.erase(it);
+
+	if(clause.is_axiom())
+	{
+		auto seen = axioms.find(&clause);
+		if(seen == axioms.end())
+		{
+			axioms[&clause] = index;
+			write_node(index, clause, used, "");
+		}
+		if( ! root) add_premise(at, seen == axioms.end() ? index : seen->second);
+	}
+	else if(clause.is_learned() || root)
+	{
+		if(clause.is_learned()) learned.insert(index);
+		if( ! root) add_premise(at, index);
+		open[index] = derivation{&clause, used, 1, 0, {}};
+		current = index;
+		current_position = position{index, 0};
+	}
+	else
+	{
+		open.at(at.owner).steps++;
+		open.at(at.owner).pending--;
+		current = index;
+		current_position = at;
+	}
+}
+
+void DotWriter::summary_edge(int from, int to)
+{
+	assert(from == current);
+	position at{current_position.owner, current_position.depth + 1};
+
+	// A second edge to a clause is only possible for learned clauses,
+	// whether the traversal reached them already or not
+	if(learned.count(to) > 0 || queued.count(to) > 0)
+	{
+		derivation& d = open.at(at.owner);
+		d.pending++;
+		add_premise(at, to);
+		return;
+	}
+
+	queued[to] = at;
+	open.at(at.owner).pending++;
+}
+
+void DotWriter::add_premise(const position& at, int premise_index)
+{
+	derivation& d = open.at(at.owner);
+	d.pending--;
+
+	auto it = d.premises.find(premise_index);
+	if(it == d.premises.end()) d.premises[premise_index] = premise{at.depth, 1};
+	else
+	{
+		it->second.chain_length = std::min(it->second.chain_length, at.depth);
+		it->second.pivots++;
+	}
+
+	if(d.pending == 0 && at.owner != current_position.owner) finish(at.owner);
+}
+
+void DotWriter::finish_current()
+{
+	if(current == -1) return;
+
+	int owner = current_position.owner;
+	current = -1;
+	current_position.owner = -1;
+	if(open.count(owner) > 0 && open.at(owner).pending == 0) finish(owner);
+}
+
+void DotWriter::finish(int owner)
+{
+	const derivation& d = open.at(owner);
+	write_node(owner, *d.clause, d.used, "\\n" + std::to_string(d.steps) + " steps");
+
+	for(const std::pair<const int, premise>& p : d.premises)
+	{
+		writer << owner << "->" << p.first << " [label=\"len " << p.second.chain_length << ", pivots " << p.second.pivots << "\"];\n";
+	}
+
+	open.erase(owner);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <ostream>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include "buffered_writer.hpp"
+#include "clause.hpp"
+
+// DotWriter emits the resolution graph as GraphViz while it is being
+// traversed, so that exporting does not need a copy of the graph. Node
+// indices are the traversal indices of ResolutionGraph, and the output uses
+// the same labels and styles as the Boost based printing (see
+// resolution_graph_extras.hpp)
+//
+// When summarizing, the derivation of each learned clause (and of the
+// refutation) is collapsed into a single node labelled with its number of
+// resolution steps. Its edges go to the learned clauses and axioms it
+// resolves, labelled with the length of the chain from that clause down to
+// the learned clause and the number of steps that resolve on it. Axioms
+// appear once instead of once per use. A derivation is written as soon as
+// the traversal has reached all of its clauses, so only the derivations in
+// the traversal's queue are held
+class DotWriter
+{
+public:
+	DotWriter(std::ostream& out, bool _include_unused, bool _summarize = false);
+	~DotWriter();
+
+	void node(int index, const Clause& clause, bool used);
+	// Edge from a resolvent to one of the clauses it was resolved from
+	void edge(int from, int to, const Clause& resolvent, bool used);
+
+	bool includes_unused() const;
+
+private:
+	// A learned clause or axiom resolved by a derivation
+	struct premise
+	{
+		long long chain_length;
+		long long pivots;
+	};
+
+	// The derivation of a learned clause (or the refutation) that the
+	// traversal has not finished yet
+	struct derivation
+	{
+		const Clause* clause;
+		bool used;
+		long long steps;
+		// Clauses of the derivation queued but not reached yet
+		long long pending;
+		std::map<int, premise> premises;
+	};
+
+	// Which derivation a queued clause belongs to, and how many resolution
+	// steps lie between it and the derivation's clause
+	struct position
+	{
+		int owner;
+		long long depth;
+	};
+
+	void write_node(int index, const Clause& clause, bool used, const std::string& extra_label);
+	void summary_node(int index, const Clause& clause, bool used);
+	void summary_edge(int from, int to);
+	void add_premise(const position& at, int premise_index);
+	// Writes the derivation of the current node once it has nothing pending
+	void finish_current();
+	void finish(int owner);
+
+	BufferedWriter writer;
+	const bool include_unused;
+	const bool summarize;
+
+	std::unordered_map<int, derivation> open;
+	std::unordered_map<int, position> queued;
+	// Learned clauses already reached, and the first index of each axiom
+	std::unordered_set<int> learned;
+	std::unordered_map<const Clause*, int> axioms;
+	// The clause whose edges are being written, owner -1 if it has none
+	int current;
+	position current_position;
+};
@@ -0,0 +1,66 @@
+#include "heartbeat.hpp"
+#include "memory_accounting.hpp"
+
+progress_counters progress;
+
+namespace
+{
+	const char* phase_names[num_progress_phases] = {
+		"replay", "final_conflict", "export"
+	};
+
+	long long read(const std::atomic<long long>& counter)
+	{
+		return counter.load(std::memory_order_relaxed);
+	}
+}
+
+Heartbeat::Heartbeat(std::ostream& _out, double interval_seconds) :
+	out(_out), interval(interval_seconds), start(std::chrono::steady_clock::now()),
+	last_time(start), last_lines(0), last_events(0), stopping(false)
+{
+	// Started last, once every member it reads is initialized
+	thread = std::thread(&Heartbeat::run, this);
+}
+
+Heartbeat::~Heartbeat()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void Heartbeat::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while( ! wake.wait_for(lock, interval, [this]() { return stopping; })) beat();
+}
+
+void Heartbeat::beat()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double since_last = std::chrono::duration<double>(now - last_time).count();
+
+	long long lines = read(progress.lines);
+	long long events = read(progress.events);
+	int phase = progress.phase.load(std::memory_order_relaxed);
+
+	out << "{\"elapsed_seconds\": " << std::chrono::duration<double>(now - start).count()
+		<< ", \"phase\": \"" << phase_names[phase] << "\""
+		<< ", \"lines\": " << lines << ", \"lines_per_second\": " << (since_last > 0 ? (lines - last_lines) / since_last : 0)
+		<< ", \"events\": " << events << ", \"events_per_second\": " << (since_last > 0 ? (events - last_events) / since_last : 0)
+		<< ", \"learned\": " << read(progress.learned)
+		<< ", \"live_clauses\": " << read(progress.live_clauses)
+		<< ", \"trail_size\": " << read(progress.trail_size)
+		<< ", \"restarts\": " << read(progress.restarts)
+		<< ", \"relocations\": " << read(progress.relocations)
+		<< ", \"memory_bytes\": " << read(progress.memory_bytes)
+		<< ", \"peak_rss_kb\": " << peak_rss_kb() << "}" << std::endl;
+
+	last_time = now;
+	last_lines = lines;
+	last_events = events;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+// What the replaying thread is doing, reported with every heartbeat
+enum progress_phase
+{
+	progress_replay = 0,
+	progress_final_conflict,
+	progress_export,
+	num_progress_phases
+};
+
+// Counters the replaying thread publishes for the heartbeat thread. There is
+// a single writer, so every field is stored with relaxed ordering and the
+// heartbeat may see a slightly inconsistent mix of fields
+struct progress_counters
+{
+	std::atomic<int> phase{progress_replay};
+	std::atomic<long long> lines{0};
+	std::atomic<long long> events{0};
+	std::atomic<long long> learned{0};
+	std::atomic<long long> live_clauses{0};
+	std::atomic<long long> trail_size{0};
+	std::atomic<long long> restarts{0};
+	std::atomic<long long> relocations{0};
+	std::atomic<long long> memory_bytes{0};
+};
+
+extern progress_counters progress;
+
+inline void publish(std::atomic<long long>& counter, long long value)
+{
+	counter.store(value, std::memory_order_relaxed);
+}
+
+// Writes one NDJSON line with the published counters and their rates since
+// the previous line every interval, from its own thread, until destroyed
+class Heartbeat
+{
+public:
+	Heartbeat(std::ostream& _out, double interval_seconds);
+	~Heartbeat();
+
+private:
+	void run();
+	void beat();
+
+	std::ostream& out;
+	const std::chrono::duration<double> interval;
+	const std::chrono::steady_clock::time_point start;
+
+	std::chrono::steady_clock::time_point last_time;
+	long long last_lines;
+	long long last_events;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+	std::thread thread;
+};
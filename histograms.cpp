@@ -0,0 +1,49 @@
+#include "histograms.hpp"
+#include <algorithm>
+#include <utility>
+
+bool histograms_active = false;
+long long histogram_counts[num_histograms][histogram_buckets];
+std::vector<long long> regularity_by_variable;
+
+namespace
+{
+	const char* histogram_names[num_histograms] = {
+		"resolvent_width", "learned_width", "learned_chain_length",
+		"skipped_per_analyze", "minimize_removed"
+	};
+}
+
+void enable_histograms()
+{
+	histograms_active = true;
+}
+
+void print_histograms(std::ostream& out, size_t top_k)
+{
+	out << "{\"histograms\": {";
+	for(int h=0; h < num_histograms; h++)
+	{
+		int used = histogram_buckets;
+		while(used > 0 && histogram_counts[h][used - 1] == 0) used--;
+
+		out << "\"" << histogram_names[h] << "\": [";
+		for(int b=0; b < used; b++) out << (b == 0 ? "" : ", ") << histogram_counts[h][b];
+		out << "], ";
+	}
+
+	std::vector<std::pair<long long, int> > violations;
+	for(size_t v=0; v < regularity_by_variable.size(); v++)
+	{
+		if(regularity_by_variable[v] > 0) violations.push_back(std::make_pair(-regularity_by_variable[v], (int) v));
+	}
+	top_k = std::min(top_k, violations.size());
+	std::partial_sort(violations.begin(), violations.begin() + top_k, violations.end());
+
+	out << "\"regularity_by_variable\": [";
+	for(size_t i=0; i < top_k; i++)
+	{
+		out << (i == 0 ? "" : ", ") << "{\"variable\": " << violations[i].second << ", \"violations\": " << -violations[i].first << "}";
+	}
+	out << "]}}" << std::endl;
+}
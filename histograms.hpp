@@ -0,0 +1,56 @@
+#pragma once
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+// The bucket of every log2 histogram in the output (--histograms and
+// --reuse): bucket 0 counts zeros and bucket b > 0 counts values in
+// [2^(b-1), 2^b)
+inline int log2_bucket(unsigned long long value)
+{
+	int bucket = 0;
+	for(; value > 0; value >>= 1) bucket++;
+	return bucket;
+}
+
+// The same for values beyond 64 bits, like tree-like copy counts. Values
+// below 1 count as zeros
+inline int log2_bucket_float(long double value)
+{
+	return value < 1 ? 0 : std::ilogb(value) + 1;
+}
+
+// Distributions collected by --histograms as a side effect of the replay and
+// the graph traversal, with fixed log2 buckets
+enum histogram_kind
+{
+	histogram_resolvent_width = 0,
+	histogram_learned_width,
+	histogram_chain_length,
+	histogram_skipped_per_analyze,
+	histogram_minimize_removed,
+	num_histograms
+};
+
+const int histogram_buckets = 64;
+
+extern bool histograms_active;
+extern long long histogram_counts[num_histograms][histogram_buckets];
+// Regularity violations in the used proof, per pivot variable
+extern std::vector<long long> regularity_by_variable;
+
+inline void histogram_add(histogram_kind kind, unsigned long long value)
+{
+	histogram_counts[kind][log2_bucket(value)]++;
+}
+
+inline void histogram_violation(int variable)
+{
+	if(regularity_by_variable.size() <= (size_t) variable) regularity_by_variable.resize(variable + 1, 0);
+	regularity_by_variable[variable]++;
+}
+
+void enable_histograms();
+// Writes every histogram (without trailing empty buckets) and the top_k
+// variables with the most regularity violations as a single JSON object
+void print_histograms(std::ostream& out, size_t top_k);
@@ -0,0 +1,35 @@
+#include "learned_log.hpp"
+#include <vector>
+
+namespace
+{
+	const char* minimization_names[] = {"none", "basic", "full"};
+}
+
+LearnedLog::LearnedLog(std::ostream& out) : writer(out)
+{
+}
+
+void LearnedLog::record(const learned_record& r, const Clause& learned)
+{
+	// The learned clause itself is not an intermediate clause
+	long long intermediate = -1, violations = 0;
+	std::vector<const Clause*> stack;
+	if(learned.is_resolvent()) stack.push_back(&learned);
+	else intermediate = 0;
+
+	while( ! stack.empty())
+	{
+		const Clause* clause = stack.back();stack.pop_back();
+		intermediate++;
+		if(clause->violated_regularity()) violations++;
+
+		const std::pair<std::shared_ptr<const Clause>, std::shared_ptr<const Clause> > parents = clause->resolved_from();
+		if(parents.first->is_resolvent() && ! parents.first->is_learned()) stack.push_back(parents.first.get());
+		if(parents.second->is_resolvent() && ! parents.second->is_learned()) stack.push_back(parents.second.get());
+	}
+
+	writer << "{\"learned\": " << r.ordinal << ", \"cref\": " << r.cref << ", \"width\": " << learned.width()
+		<< ", \"steps\": " << r.steps << ", \"intermediate\": " << intermediate << ", \"regularity_violations\": " << violations
+		<< ", \"skipped\": " << r.skipped << ", \"minimization\": \"" << minimization_names[r.minimization] << "\"}\n";
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <ostream>
+#include "buffered_writer.hpp"
+#include "clause.hpp"
+
+// How a learned clause was minimized, if at all
+enum minimization_kind
+{
+	minimization_none = 0,
+	minimization_basic,
+	minimization_full
+};
+
+// What is known about a derivation at the time its clause is learned
+struct learned_record
+{
+	long long ordinal;
+	// -1 for learned units (LU)
+	int cref;
+	// Resolution steps (U) of the conflict analysis
+	long long steps;
+	// Literals skipped over all steps (S)
+	long long skipped;
+	minimization_kind minimization;
+};
+
+// LearnedLog writes one JSON line per learned clause as soon as it is
+// learned, so that tools can follow derivations without the proof DAG
+class LearnedLog
+{
+public:
+	LearnedLog(std::ostream& out);
+
+	// Also counts the intermediate clauses and regularity violations of the
+	// derivation, which ends at the learned clauses and axioms it resolves
+	void record(const learned_record& r, const Clause& learned);
+
+private:
+	BufferedWriter writer;
+};
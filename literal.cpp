@@ -16,6 +16,12 @@ Literal::Literal(std::string str)
 	}
 }
 
+Literal::Literal(int variable, bool negated)
+{
+	variable_number = variable;
+	is_negated = negated;
+}
+
 Literal::Literal(const Literal& l)
 {
 	variable_number = l.variable();
@@ -6,6 +6,7 @@ class Literal
 {
 public:
 	Literal(std::string str);
+	Literal(int variable, bool negated);
 	Literal(const Literal& l);
 	std::string const to_str() const;
 	int variable() const;
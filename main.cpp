@@ -7,12 +7,178 @@
 #include "clause.hpp"
 #include "solver_shadow.hpp"
 #include "resolution_graph.hpp"
+#include "proof_events.hpp"
+#include "trace_reader.hpp"
+#include "proof_dag.hpp"
+#include "proof_export.hpp"
+#include "proof_index.hpp"
+#include "proof_reuse.hpp"
+#include "proof_compression.hpp"
+#include "profiler.hpp"
+#include "heartbeat.hpp"
+#include "timeline.hpp"
+#include "histograms.hpp"
+#include "windows.hpp"
+#include "analysis_passes.hpp"
 #include <boost/program_options.hpp>
 #include <memory>
 #include <stdlib.h>
 
-void jsonPrinFloat(std::ostream& s, long double value) {
-	s << "\"" << value << "\"";
+// Output settings given on the command line
+struct trace_options
+{
+	bool print_graph = false;
+	bool print_with_unused = false;
+	bool summarize_graph = false;
+	bool print_input = false;
+	bool export_proof = false;
+	proof_format format = tracecheck_text;
+	bool write_index = false;
+	bool profile = false;
+	bool memory = false;
+	double heartbeat_interval = 0;
+	bool timeline = false;
+	bool verify = false;
+	bool reuse = false;
+	bool compress = false;
+	bool export_compressed = false;
+	bool histograms = false;
+	bool windows = false;
+	bool learned_log = false;
+	bool reclaim = false;
+	bool compact_clauses = false;
+	size_t reuse_top = 10;
+	std::string snapshot;
+	int snapshot_interval = 10;
+	int threads = 1;
+	std::string resume;
+	analysis_passes passes = all_passes;
+
+	// Standard input unless --trace is given
+	std::ifstream trace_file;
+	std::fstream graph_file;
+	std::fstream proof_file;
+	std::fstream compressed_file;
+	std::fstream index_file;
+	std::fstream heartbeat_file;
+	std::fstream timeline_file;
+	std::fstream learned_log_file;
+};
+
+// Reads the trace (standard input or --trace) and applies it to the solver shadow,
+// instantiated once per ignore mode. Returns false if verification failed
+template<ignore_mode mode>
+bool apply_trace(trace_options& options)
+{
+	std::unique_ptr<Heartbeat> heartbeat;
+	if(options.heartbeat_interval > 0)
+	{
+		std::ostream& out = options.heartbeat_file.is_open() ? options.heartbeat_file : std::cerr;
+		heartbeat.reset(new Heartbeat(out, options.heartbeat_interval));
+	}
+
+	ProofEvents<mode> events;
+	events.verify(options.verify);
+	// Removed clauses only matter to the unused pass and the index, so
+	// without both they are reclaimed, and relocations sweep the clause list
+	events.reclaim_removed(options.reclaim || ( ! (options.passes & pass_unused) && ! options.write_index));
+	events.compact_clauses(options.compact_clauses);
+	events.run_passes(options.passes);
+
+	std::unique_ptr<LearnedLog> learned_log;
+	if(options.learned_log)
+	{
+		learned_log.reset(new LearnedLog(options.learned_log_file));
+		events.log_learned(learned_log.get());
+	}
+	std::istream& in = options.trace_file.is_open() ? options.trace_file : std::cin;
+	TraceReader<mode> reader(in, events, options.print_input);
+
+	if( ! options.resume.empty())
+	{
+		std::ifstream snapshot_file(options.resume, std::ifstream::binary);
+		long long offset, lines;
+		if( ! events.load(snapshot_file, offset, lines))
+		{
+			std::cout << "ERROR: " << options.resume << " is not a complete snapshot taken in ignore mode " << mode << " with the selected --metrics" << std::endl;
+			return false;
+		}
+
+		in.seekg(offset);
+		reader.resume(offset, lines);
+	}
+	reader.tokenize_in_parallel(options.threads);
+	if( ! options.snapshot.empty()) reader.snapshot_at_restarts(options.snapshot, options.snapshot_interval);
+
+	// An incremental solver reports a final conflict per unsatisfiable call,
+	// each of which gets its own statistics. Graphs, proofs, the index and
+	// reuse and compression cover the first refutation only
+	int ref;
+	int refutations = 0;
+	while(reader.read_until_conflict(ref))
+	{
+		bool first = ++refutations == 1;
+		progress.phase.store(progress_final_conflict, std::memory_order_relaxed);
+
+		// The graph is streamed out during traversal, so there is nothing left
+		// to print afterwards
+		std::unique_ptr<DotWriter> dot;
+		if(first && options.print_graph) dot.reset(new DotWriter(options.graph_file, options.print_with_unused, options.summarize_graph));
+
+		ResolutionGraph gb = events.on_final_conflict(ref, false, dot.get());
+		dot.reset();
+
+		if(options.verify)
+		{
+			events.verify_refutation(gb);
+			if( ! events.consistent()) break;
+		}
+
+		// Printed after the statistics like the other optional objects
+		std::ostringstream reuse_output;
+		if(first && (options.export_proof || options.write_index || options.reuse || options.compress))
+		{
+			PROFILE_SCOPE(phase_export);
+			progress.phase.store(progress_export, std::memory_order_relaxed);
+			std::unique_ptr<ProofDag> dag = gb.take_used_proof();
+			if(options.export_proof) write_tracecheck(*dag, options.proof_file, options.format);
+			if(options.reuse) ProofReuse(*dag).write_json(reuse_output, options.reuse_top);
+
+			if(options.compress)
+			{
+				PROFILE_SCOPE(phase_compress);
+				ProofCompression compression(*dag);
+				compression.write_json(reuse_output);
+				if(options.export_compressed) compression.write_tracecheck(options.compressed_file, options.format);
+			}
+
+			if(options.write_index)
+			{
+				dag->add_unused(events.shadow());
+				write_proof_index(*dag, options.index_file);
+			}
+		}
+
+		write_statistics(std::cout, gb.vertex_statistics());
+		std::cout << reuse_output.str();
+		progress.phase.store(progress_replay, std::memory_order_relaxed);
+	}
+
+	if( ! events.consistent())
+	{
+		std::cout << "ERROR: " << events.inconsistency() << std::endl;
+		return false;
+	}
+	// Without a final conflict there are no statistics, but the run still
+	// has its timeline, profile and the other objects about the replay
+	heartbeat.reset();
+	if(options.timeline) write_timeline(options.timeline_file);
+
+	if(options.histograms) print_histograms(std::cout, 10);
+	if(options.windows) print_windows(std::cout);
+	if(options.profile) print_profile(std::cout, options.threads > 1);
+	if(options.memory) print_memory(std::cout);
+	return true;
 }
 
 int main(int argc, char** argv)
@@ -27,21 +193,45 @@ int main(int argc, char** argv)
 	//
 	// (modes 2 and 3 introduce regularity violations because skipped literals will also be
 	// resolved away during final conflict resolution)
-	ignore_mode mode;
-
-	bool print_graph = false;
-	bool print_with_unused = false;
-	bool print_input = false;
-
-	std::fstream graph_file;
+	ignore_mode mode = none;
+	trace_options options;
 
+	std::string metrics_help = "comma separated analysis passes or statistics to compute (default all), of: " + metric_names();
 	boost::program_options::options_description desc("Supported options");
 	desc.add_options()
 		("help", "show this help")
 		("ignore-mode", boost::program_options::value<int>(), "ignore mode (0=none, 1=learn, 2=resolve_unit) (see code for details)")
 		("print-graph", boost::program_options::value<std::string>(), "print out resolution graph as DOT to the given filename")
 		("include-unused", "include unused learned clauses in graph")
+		("summarize-graph", "collapse the derivation of each learned clause into one node in --print-graph, with edges to the learned clauses and axioms it resolves")
 		("print-input", "print out input lines as they are consumed")
+		("export-proof", boost::program_options::value<std::string>(), "write the used part of the refutation as a TraceCheck proof to the given filename")
+		("proof-format", boost::program_options::value<std::string>(), "format of --export-proof and --export-compressed (text or binary, default text)")
+		("compress", "compress the used part of the refutation with RecyclePivots and LowerUnits, and print its size and tree-like size as an extra JSON object after the statistics")
+		("export-compressed", boost::program_options::value<std::string>(), "write the proof compressed by --compress as a TraceCheck proof to the given filename (implies --compress)")
+		("profile", "print time spent per phase as an extra JSON object after the statistics")
+		("memory", "print memory held per subsystem and the peak RSS as an extra JSON object after the statistics")
+		("heartbeat", boost::program_options::value<double>(), "every given number of seconds, write progress (throughput, learned and live clauses, trail size, restarts, relocations and memory) as a JSON line to standard error")
+		("heartbeat-file", boost::program_options::value<std::string>(), "write the --heartbeat lines to the given filename instead")
+		("timeline", boost::program_options::value<std::string>(), "write restart intervals, slow or wide learned clause derivations, relocations and the graph build as Chrome trace-event JSON to the given filename")
+		("timeline-min-width", boost::program_options::value<int>()->default_value(32), "record learned clause derivations of at least this width")
+		("timeline-min-us", boost::program_options::value<double>()->default_value(100), "record learned clause derivations that took at least this many microseconds")
+		("timeline-capacity", boost::program_options::value<size_t>()->default_value(1 << 20), "spans kept per thread, older spans are dropped")
+		("verify", "check learned clauses (L and LU, not in ignore mode 0) and the refutation against the trace using clause fingerprints, also in release builds")
+		("reuse", "print how often learned clauses and axioms are copied in the tree-like expansion of the proof (histograms and the most copied) as an extra JSON object after the statistics")
+		("reuse-top", boost::program_options::value<size_t>(), "number of most copied clauses printed by --reuse (default 10)")
+		("histograms", "print log2 histograms of resolvent and learned clause widths, learned clause chain lengths, skipped literals per U and minimization removals, and the variables with the most regularity violations, as an extra JSON object after the statistics")
+		("window", boost::program_options::value<long long>(), "print, per window of the given number of consecutive learned clauses, the restarts they were learned in, how many the proof uses, their mean width and their tree edge violations as an extra JSON object after the statistics")
+		("learned-log", boost::program_options::value<std::string>(), "write one JSON line per learned clause (width, resolution steps, intermediate clauses, regularity violations, skipped literals, minimization) to the given filename as it is learned")
+		("reclaim", "free removed clauses (R) that no other clause depends on; they are then missing from the unused statistics and graph")
+		("compact-clauses", "at restarts, store the literals of axioms and learned clauses that are not reasons and were not resolved recently in a compact encoding")
+		("trace", boost::program_options::value<std::string>(), "read the trace from the given filename instead of standard input")
+		("threads", boost::program_options::value<int>(), "decode the trace in large chunks on the given number of threads, while the main thread applies the events in order (default 1, decoding on the main thread)")
+		("snapshot", boost::program_options::value<std::string>(), "periodically save the solver shadow to the given filename, at restarts (RS)")
+		("snapshot-interval", boost::program_options::value<int>()->default_value(10), "restarts between --snapshot saves")
+		("resume", boost::program_options::value<std::string>(), "continue from a --snapshot saved in the same ignore mode, skipping the part of the --trace it covers")
+		("write-index", boost::program_options::value<std::string>(), "write the whole clause DAG as a memory mappable index for ProofQuery to the given filename")
+		("metrics", boost::program_options::value<std::string>(), metrics_help.c_str())
 	;
 
 	boost::program_options::variables_map vm;
@@ -69,292 +259,176 @@ int main(int argc, char** argv)
 	if(vm.count("print-graph"))
 	{
 		std::string file_name = vm["print-graph"].as<std::string>();
-		print_graph = true;
-		graph_file.open(file_name, std::fstream::out);
-		if(vm.count("include-unused")) print_with_unused = true;
+		options.print_graph = true;
+		options.graph_file.open(file_name, std::fstream::out);
+		if(vm.count("include-unused")) options.print_with_unused = true;
+		if(vm.count("summarize-graph")) options.summarize_graph = true;
 	}
 
-	if(vm.count("print-input")) print_input = true;
-
+	if(vm.count("print-input")) options.print_input = true;
 
-	std::string line;
-	SolverShadow solver(mode);
-
-	while(std::getline(std::cin, line))
+	if(vm.count("export-proof"))
 	{
-		std::istringstream ss(line);
-
-		std::string instruction;
-		ss >> instruction;
+		std::string file_name = vm["export-proof"].as<std::string>();
+		options.export_proof = true;
+		options.proof_file.open(file_name, std::fstream::out | std::fstream::binary);
+	}
 
-		print_input && std::cout << line << std::endl;
+	if(vm.count("compress")) options.compress = true;
+	if(vm.count("export-compressed"))
+	{
+		std::string file_name = vm["export-compressed"].as<std::string>();
+		options.compress = true;
+		options.export_compressed = true;
+		options.compressed_file.open(file_name, std::fstream::out | std::fstream::binary);
+	}
 
-		if(instruction == "NV")
+	if(vm.count("profile"))
+	{
+		if( ! enable_profiling())
 		{
-			int num;
-			ss >> num;
-
-			solver.num_vars(num);
+			std::cout << "ERROR: Built without profiling support (ENABLE_PROFILING=OFF)" << std::endl;
+			return 1;
 		}
-		else if(instruction == "I")
-		{
-			int ref, num_literals;
-			std::vector<Literal> literals;
+		options.profile = true;
+	}
 
-			ss >> ref >> num_literals;
+	if(vm.count("memory")) options.memory = true;
+	if(vm.count("verify")) options.verify = true;
+	if(vm.count("reuse")) options.reuse = true;
+	if(vm.count("reclaim")) options.reclaim = true;
+	if(vm.count("compact-clauses")) options.compact_clauses = true;
 
-			std::string ls;
-			for(int i=0; i < num_literals; i++)
-			{
-				ss >> ls;
-				literals.push_back(Literal(ls));
-			}
-
-			solver.add_clause(std::make_shared<Clause>(Clause(literals)), ref);
-		}
-		else if(instruction == "D")
+	if(vm.count("trace"))
+	{
+		std::string file_name = vm["trace"].as<std::string>();
+		options.trace_file.open(file_name, std::ifstream::binary);
+		if( ! options.trace_file)
 		{
-			std::string ls;
-			ss >> ls;
-			solver.decide(ls);
+			std::cout << "ERROR: Cannot open " << file_name << std::endl;
+			return 1;
 		}
-		else if(instruction == "P")
+	}
+
+	if(vm.count("threads"))
+	{
+		options.threads = vm["threads"].as<int>();
+		if(options.threads < 1)
 		{
-			std::string ls;
-			int ref;
-			ss >> ls >> ref;
-			solver.propagate(ls, ref);
+			std::cout << "ERROR: --threads must be at least 1" << std::endl;
+			return 1;
 		}
-		else if(instruction == "PU")
+		if(options.threads > 1 && options.print_input)
 		{
-			std::string ls;
-			ss >> ls;
-			Literal l(ls);
-			solver.propagate(l);
+			std::cout << "ERROR: --print-input needs --threads 1" << std::endl;
+			return 1;
 		}
-		else if(instruction == "U")
-		{
-			std::vector<Literal> empty = {};
-			std::shared_ptr<const Clause> remaining;
+	}
 
-			while(true)
-			{
-				bool should_read = true;
-
-				print_input && std::cout << line << std::endl;
-
-				if(instruction == "U")
-				{
-					int ref;
-					ss >> ref;
-					std::vector<Literal> to_skip;
-
-					while(true)
-					{
-						// Read one more line and see if we get an "S" instruction
-						std::getline(std::cin, line);
-						ss = std::istringstream(line);
-						ss >> instruction;
-						should_read = false;
-
-						if(instruction == "S")
-						{
-							int num_skipped;
-							ss >> num_skipped;
-							should_read = true;
-
-							std::string literal;
-
-							for(int i=0; i < num_skipped; i++)
-							{
-								ss >> literal;
-								to_skip.push_back(Literal(literal));
-							}
-
-						}
-						else
-						{
-							break;
-						}
-					}
-
-					std::shared_ptr<const Clause> c = solver.clause_by_cref(ref);
-
-					if(to_skip.size() > 0)
-					{
-						c = solver.skip(ref, to_skip);
-					}
-
-					if(remaining == nullptr)
-					{
-						remaining = c;
-					}
-					else
-					{
-						remaining = Clause::resolve(remaining, c);
-					}
-
-				}
-				else if(instruction == "LU")
-				{
-					std::string l;
-					ss >> l;
-					Literal expected_unit(l);
-
-					assert(remaining->unit() || mode == none);
-					assert(remaining->first_literal() == expected_unit || mode == none);
-					solver.add_unit(std::make_shared<const Clause>(Clause(*remaining, true)), expected_unit);
-					break;
-				}
-				else if(instruction == "L")
-				{
-
-					int ref, num_literals;
-					std::vector<Literal> literals;
-					ss >> ref >> num_literals;
-
-					std::string ls;
-					for(int i=0; i < num_literals; i++)
-					{
-						ss >> ls;
-						literals.push_back(Literal(ls));
-					}
-
-					Clause should_be(literals);
-
-					assert(should_be == *remaining.get() || mode == none);
-
-					//if(remaining->is_axiom()) std::cout << "WARNING: learned using only conflict clause" << std::endl;
-					solver.add_clause(std::make_shared<const Clause>(Clause(*remaining, true)), ref);
-					break;
-				}
-				else if(instruction == "MNM")
-				{
-					int count;
-					ss >> count;
-					std::vector<Literal> removed_literals;
-					std::string ls;
-
-					for(int i=0; i < count; i++)
-					{
-						ss >> ls;
-						removed_literals.push_back(Literal(ls));
-					}
-
-					remaining = solver.minimize(remaining, removed_literals);
-				}
-				else if(instruction == "MNM2")
-				{
-					int count;
-					ss >> count;
-					std::vector<Literal> removed_literals;
-					std::string ls;
-
-					for(int i=0; i < count; i++)
-					{
-						ss >> ls;
-						removed_literals.push_back(Literal(ls));
-					}
-
-					remaining = solver.minimize_full(remaining, removed_literals);
-				}
-				else if(instruction == "B")
-				{
-					int level;
-					ss >> level;
-					solver.backtrack(level);
-				}
-				else
-				{
-					print_input && std::cout << instruction << std::endl;
-					assert(instruction == "");
-				}
-
-				// Some branches need to read input
-				// If they have been executed, do not read one more line
-				if( ! should_read) continue;
-
-				if( ! std::getline(std::cin, line)) break;
-				ss = std::istringstream(line);
-				ss >> instruction;
-			}
-		}
-		else if(instruction == "B")
+	if(vm.count("snapshot"))
+	{
+		options.snapshot = vm["snapshot"].as<std::string>();
+		options.snapshot_interval = vm["snapshot-interval"].as<int>();
+		if(options.snapshot_interval <= 0)
 		{
-			int level;
-			ss >> level;
-
-			solver.backtrack(level);
-
+			std::cout << "ERROR: Snapshot interval must be positive" << std::endl;
+			return 1;
 		}
-		else if(instruction == "RS")
+	}
+
+	if(vm.count("resume"))
+	{
+		// Standard input cannot be positioned at the offset of the snapshot
+		if( ! vm.count("trace"))
 		{
-			solver.restart();
+			std::cout << "ERROR: --resume requires --trace" << std::endl;
+			return 1;
 		}
-		else if(instruction == "C")
-		{
-			int ref;
-			ss >> ref;
+		options.resume = vm["resume"].as<std::string>();
+	}
 
-			ResolutionGraph gb(solver, ref, print_graph);
-			if(print_graph)
-			{
-				if(!print_with_unused) gb.remove_unused();
-				gb.print_graphviz(graph_file);
-			}
+	if(vm.count("learned-log"))
+	{
+		options.learned_log = true;
+		options.learned_log_file.open(vm["learned-log"].as<std::string>(), std::fstream::out);
+	}
+	if(vm.count("histograms"))
+	{
+		options.histograms = true;
+		enable_histograms();
+	}
+	if(vm.count("window"))
+	{
+		long long width = vm["window"].as<long long>();
+		if(width <= 0)
+		{
+			std::cout << "ERROR: Window must be positive" << std::endl;
+			return 1;
+		}
+		options.windows = true;
+		enable_windows(width);
+	}
+	if(vm.count("reuse-top")) options.reuse_top = vm["reuse-top"].as<size_t>();
 
-			statistics s = gb.vertex_statistics();
+	if(vm.count("heartbeat"))
+	{
+		options.heartbeat_interval = vm["heartbeat"].as<double>();
+		if(options.heartbeat_interval <= 0)
+		{
+			std::cout << "ERROR: Heartbeat interval must be positive" << std::endl;
+			return 1;
+		}
 
-			std::cout << "{";
-			std::cout << "\"used_axioms\": " << s.used_axioms << ", \"unused_axioms\": " << s.unused_axioms << ",";
-			std::cout << "\"used_intermediate\": " << s.used_intermediate << ", \"unused_intermediate\": " << s.unused_intermediate << ",";
-			std::cout << "\"used_learned\": " << s.used_learned << ", \"unused_learned\": " << s.unused_learned << ",";
+		if(vm.count("heartbeat-file")) options.heartbeat_file.open(vm["heartbeat-file"].as<std::string>(), std::fstream::out);
+	}
 
-			std::cout << "\"tree_edge_violations\": " << s.tree_edge_violations << ", \"tree_vertex_violations\": " << s.tree_vertex_violations << ",";
-			std::cout << "\"tree_copy_cost\": ";
-			jsonPrinFloat(std::cout, s.copy_cost);
-			std::cout << ", ";
+	if(vm.count("timeline"))
+	{
+		options.timeline = true;
+		options.timeline_file.open(vm["timeline"].as<std::string>(), std::fstream::out);
+		enable_timeline(vm["timeline-capacity"].as<size_t>(), vm["timeline-min-width"].as<int>(), vm["timeline-min-us"].as<double>());
+	}
 
-			std::cout << "\"regularity_violations_total\": " << s.regularity_violations_total << ", \"regularity_violation_variables\": " << s.regularity_violation_variables << ",";
+	if(vm.count("write-index"))
+	{
+		std::string file_name = vm["write-index"].as<std::string>();
+		options.write_index = true;
+		options.index_file.open(file_name, std::fstream::out | std::fstream::binary);
+	}
 
-			std::cout << "\"max_width\": " << s.width << "}" << std::endl;
-			exit(0);
-		}
-		else if(instruction == "R")
+	if(vm.count("proof-format"))
+	{
+		std::string format = vm["proof-format"].as<std::string>();
+		if(format == "binary") options.format = tracecheck_binary;
+		else if(format != "text")
 		{
-			int ref;
-			ss >> ref;
-			solver.remove_clause(ref);
+			std::cout << "ERROR: Proof format must be text or binary" << std::endl;
+			return 1;
 		}
-		else if(instruction == "M")
-		{
-			std::vector<std::pair<int, int> > moves;
+	}
 
-			while(true)
-			{
-				if(instruction == "M")
-				{
-					int from, to;
-					ss >> from >> to;
-					moves.push_back(std::make_pair(from, to));
-				}
-				else if(instruction == "RD")
-				{
-					solver.relocate(moves);
-					break;
-				}
-
-				if( ! std::getline(std::cin, line)) break;
-				ss = std::istringstream(line);
-				ss >> instruction;
-			}
-		}
-		else if(instruction == "RD")
-		{
-		}
-		else
+	if(vm.count("metrics"))
+	{
+		std::string unknown;
+		if( ! parse_metrics(vm["metrics"].as<std::string>(), options.passes, unknown))
 		{
-			print_input && std::cout << instruction << std::endl;
+			std::cout << "ERROR: Unknown metric " << unknown << std::endl;
+			return 1;
 		}
 	}
+
+	// Options that read what a pass collects run it as well
+	if(options.print_with_unused) options.passes |= pass_unused;
+	if(options.histograms) options.passes |= pass_regularity;
+	if(options.windows) options.passes |= pass_tree_violations;
+	if(options.export_proof || options.write_index || options.reuse || options.compress) options.passes |= pass_export;
+
+	// Select the specialization once, so that the ignore mode is not checked
+	// for every event
+	switch(mode)
+	{
+		case none: return apply_trace<none>(options) ? 0 : 1;
+		case learn: return apply_trace<learn>(options) ? 0 : 1;
+		case resolve_unit: return apply_trace<resolve_unit>(options) ? 0 : 1;
+	}
 }
@@ -0,0 +1,42 @@
+#include "memory_accounting.hpp"
+#include <sys/resource.h>
+
+memory_counter memory_usage[num_memory_categories];
+
+namespace
+{
+	const char* category_names[num_memory_categories] = {
+		"axioms", "learned", "intermediate", "removed_variables",
+		"clause_list", "trail", "maps", "graph"
+	};
+}
+
+long long memory_total_bytes()
+{
+	long long total = 0;
+	for(int c=0; c < num_memory_categories; c++) total += memory_usage[c].current;
+	return total;
+}
+
+long peak_rss_kb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+	// macOS reports bytes
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+void print_memory(std::ostream& out)
+{
+	out << "{\"memory\": {";
+	for(int c=0; c < num_memory_categories; c++)
+	{
+		out << "\"" << category_names[c] << "\": {\"bytes\": " << memory_usage[c].current << ", \"peak_bytes\": " << memory_usage[c].peak << "}, ";
+	}
+	out << "\"peak_rss_kb\": " << peak_rss_kb() << "}}" << std::endl;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+#include <ostream>
+
+// Bytes currently (and at most) held by each subsystem. Clauses account for
+// themselves when they are created and destroyed, containers of the shadow
+// and the graph use counting_allocator
+enum memory_category
+{
+	memory_axioms = 0,
+	memory_learned,
+	memory_intermediate,
+	memory_removed_variables,
+	memory_clause_list,
+	memory_trail,
+	memory_maps,
+	memory_graph,
+	num_memory_categories
+};
+
+struct memory_counter
+{
+	long long current = 0;
+	long long peak = 0;
+};
+
+extern memory_counter memory_usage[num_memory_categories];
+
+inline void memory_add(memory_category category, long long bytes)
+{
+	memory_counter& counter = memory_usage[category];
+	counter.current += bytes;
+	if(counter.current > counter.peak) counter.peak = counter.current;
+}
+
+// Standard allocator that charges everything it allocates to a category
+template<class T, memory_category category>
+struct counting_allocator
+{
+	typedef T value_type;
+
+	counting_allocator() = default;
+	template<class U>
+	counting_allocator(const counting_allocator<U, category>&) {}
+
+	template<class U>
+	struct rebind { typedef counting_allocator<U, category> other; };
+
+	T* allocate(size_t n)
+	{
+		memory_add(category, n * sizeof(T));
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		memory_add(category, -(long long) (n * sizeof(T)));
+		::operator delete(p);
+	}
+
+	template<class U>
+	bool operator==(const counting_allocator<U, category>&) const { return true; }
+	template<class U>
+	bool operator!=(const counting_allocator<U, category>&) const { return false; }
+};
+
+template<class K, class V, memory_category category>
+using counted_map = std::map<K, V, std::less<K>, counting_allocator<std::pair<const K, V>, category> >;
+
+template<class K, memory_category category>
+using counted_set = std::set<K, std::less<K>, counting_allocator<K, category> >;
+
+template<class T, memory_category category>
+using counted_vector = std::vector<T, counting_allocator<T, category> >;
+
+// Bytes currently held by all categories together
+long long memory_total_bytes();
+
+// Peak resident set size of the process in kilobytes
+long peak_rss_kb();
+
+// Writes the current and peak bytes of every category and the peak RSS as a
+// single JSON object
+void print_memory(std::ostream& out);
@@ -0,0 +1,65 @@
+#include "profiler.hpp"
+
+#ifndef RESOLUTION_GRAPH_NO_PROFILING
+
+namespace
+{
+	const char* phase_names[num_profile_phases] = {
+		"trace_replay", "input_clause", "decide", "propagate", "analyze", "skip",
+		"minimize", "learn", "backtrack", "restart", "remove", "relocate",
+		"resolve_conflict", "copy_count", "used_traversal", "unused_traversal", "export", "compress"
+	};
+
+	const char* counter_names[num_profile_counters] = {
+		"resolutions", "lines"
+	};
+}
+
+bool profiling_active = false;
+phase_timer profile_timers[num_profile_phases];
+unsigned long long profile_counters[num_profile_counters];
+
+bool enable_profiling()
+{
+	profiling_active = true;
+	return true;
+}
+
+void print_profile(std::ostream& out, bool parallel_parse)
+{
+	// Time spent replaying the trace outside of the event handlers is parsing,
+	// or waiting for the tokenizer
+	std::chrono::steady_clock::duration handlers = std::chrono::steady_clock::duration::zero();
+	for(int p=phase_input_clause; p <= phase_relocate; p++)
+	{
+		if(p != phase_skip) handlers += profile_timers[p].elapsed;
+	}
+	std::chrono::duration<double> parse = profile_timers[phase_trace_replay].elapsed - handlers;
+
+	out << "{\"profile\": {";
+	for(int p=0; p < num_profile_phases; p++)
+	{
+		std::chrono::duration<double> elapsed = profile_timers[p].elapsed;
+		out << "\"" << phase_names[p] << "\": {\"calls\": " << profile_timers[p].calls << ", \"seconds\": " << elapsed.count() << "}, ";
+	}
+	out << "\"" << (parallel_parse ? "tokenizer_wait" : "parse") << "\": {\"seconds\": " << parse.count() << "}";
+
+	for(int c=0; c < num_profile_counters; c++)
+	{
+		out << ", \"" << counter_names[c] << "\": " << profile_counters[c];
+	}
+	out << "}}" << std::endl;
+}
+
+#else
+
+bool enable_profiling()
+{
+	return false;
+}
+
+void print_profile(std::ostream& out, bool parallel_parse)
+{
+}
+
+#endif
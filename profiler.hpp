@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+
+// Phases timed by --profile. Timers are inclusive, so nested phases are
+// also counted in the phases around them (for example analyze includes skip)
+enum profile_phase
+{
+	phase_trace_replay = 0,
+	phase_input_clause,
+	phase_decide,
+	phase_propagate,
+	phase_analyze,
+	phase_skip,
+	phase_minimize,
+	phase_learn,
+	phase_backtrack,
+	phase_restart,
+	phase_remove,
+	phase_relocate,
+	phase_resolve_conflict,
+	phase_copy_count,
+	phase_used_traversal,
+	phase_unused_traversal,
+	phase_export,
+	phase_compress,
+	num_profile_phases
+};
+
+// Plain event counters
+enum profile_counter
+{
+	counter_resolutions = 0,
+	counter_lines,
+	num_profile_counters
+};
+
+// Profiling is compiled in unless the build sets RESOLUTION_GRAPH_NO_PROFILING
+// (cmake -DENABLE_PROFILING=OFF), in which case the macros below expand to
+// nothing. When compiled in, timers only read the clock after --profile
+#ifndef RESOLUTION_GRAPH_NO_PROFILING
+
+struct phase_timer
+{
+	unsigned long long calls = 0;
+	std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+};
+
+extern bool profiling_active;
+extern phase_timer profile_timers[num_profile_phases];
+extern unsigned long long profile_counters[num_profile_counters];
+
+class ProfileScope
+{
+public:
+	ProfileScope(profile_phase _phase) : phase(_phase)
+	{
+		if(profiling_active) start = std::chrono::steady_clock::now();
+	}
+	~ProfileScope()
+	{
+		if( ! profiling_active) return;
+		profile_timers[phase].calls++;
+		profile_timers[phase].elapsed += std::chrono::steady_clock::now() - start;
+	}
+
+private:
+	profile_phase phase;
+	std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(phase)
+#define PROFILE_COUNT(counter, n) (profile_counters[counter] += (n))
+
+#else
+
+#define PROFILE_SCOPE(phase)
+#define PROFILE_COUNT(counter, n)
+
+#endif
+
+// Returns false if profiling was compiled out
+bool enable_profiling();
+// Writes all timers and counters as a single JSON object. When the trace was
+// decoded on other threads (--threads), replay time outside of the handlers
+// is spent waiting for them rather than parsing
+void print_profile(std::ostream& out, bool parallel_parse = false);
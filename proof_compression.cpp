@@ -0,0 +1,411 @@
+#include "proof_compression.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+	enum node_flags
+	{
+		delete_first = 1,
+		delete_second = 2,
+		lowered = 4,
+		// All edges to the node were deleted
+		unreached = 8
+	};
+
+	int literal_code(const Literal& l)
+	{
+		return 2 * l.variable() + (l.negated() ? 1 : 0);
+	}
+
+	// Literals are sorted by variable, and so are their codes
+	std::vector<int> clause_codes(const Clause* clause)
+	{
+		std::vector<int> codes;
+		for(const Literal& l : clause->literals()) codes.push_back(literal_code(l));
+		return codes;
+	}
+
+	bool contains(const std::vector<int>& codes, int code)
+	{
+		return std::binary_search(codes.begin(), codes.end(), code);
+	}
+
+	// The pivot as it occurs in the first parent
+	int pivot_code(const dag_node& node, const std::vector<dag_node>& nodes)
+	{
+		int variable = node.clause->removed_variable().value();
+		for(const Literal& l : nodes[node.first].clause->literals())
+		{
+			if(l.variable() == variable) return literal_code(l);
+		}
+
+		assert(false);
+		return -1;
+	}
+
+	// Intersects the safe literals a node already got from other children
+	// with those of one more child
+	void add_safe_literals(std::unordered_map<long long, std::vector<int> >& safe_literals, long long node, const std::vector<int>& safe, int pivot)
+	{
+		std::vector<int> contribution(safe);
+		contribution.insert(std::lower_bound(contribution.begin(), contribution.end(), pivot), pivot);
+
+		auto it = safe_literals.find(node);
+		if(it == safe_literals.end())
+		{
+			safe_literals.emplace(node, std::move(contribution));
+			return;
+		}
+
+		std::vector<int> both;
+		std::set_intersection(it->second.begin(), it->second.end(), contribution.begin(), contribution.end(), std::back_inserter(both));
+		it->second.swap(both);
+	}
+
+	// Returns false if the clauses clash on another variable besides the pivot
+	bool resolve_codes(const std::vector<int>& first, const std::vector<int>& second, int pivot, std::vector<int>& resolvent)
+	{
+		auto it1 = first.begin();
+		auto it2 = second.begin();
+
+		while(it1 != first.end() || it2 != second.end())
+		{
+			if(it1 != first.end() && *it1 == pivot) it1++;
+			else if(it2 != second.end() && *it2 == (pivot ^ 1)) it2++;
+			else if(it2 == second.end() || (it1 != first.end() && (*it1 >> 1) < (*it2 >> 1))) resolvent.push_back(*it1++);
+			else if(it1 == first.end() || (*it2 >> 1) < (*it1 >> 1)) resolvent.push_back(*it2++);
+			else if(*it1 == *it2)
+			{
+				resolvent.push_back(*it1++);
+				it2++;
+			}
+			else return false;
+		}
+
+		return true;
+	}
+
+	std::vector<Literal> code_literals(const std::vector<int>& codes)
+	{
+		std::vector<Literal> literals;
+		for(int code : codes) literals.push_back(Literal(code >> 1, code & 1));
+		return literals;
+	}
+
+	// Marks the nodes the root depends on
+	std::vector<bool> reachable(const std::vector<compressed_node>& nodes, long long root)
+	{
+		std::vector<bool> reached(root + 1, false);
+		reached[root] = true;
+
+		for(long long i=root; i >= 0; i--)
+		{
+			if( ! reached[i] || nodes[i].first == -1) continue;
+			reached[nodes[i].first] = true;
+			reached[nodes[i].second] = true;
+		}
+
+		return reached;
+	}
+}
+
+ProofCompression::ProofCompression(const ProofDag& _dag) : dag(_dag), num_regularized(0), root(-1), failed(false), num_nodes(0), tree_nodes(0)
+{
+	if( ! compress(true) && ! compress(false))
+	{
+		// Keep the proof as it is
+		compressed.clear();
+		for(size_t i=0; i < dag.used_size(); i++)
+		{
+			const dag_node& node = dag.nodes()[i];
+			compressed.push_back(compressed_node{node.clause, node.first, node.second, 0});
+		}
+
+		root = dag.root();
+		units.clear();
+		num_regularized = 0;
+	}
+
+	std::vector<int>().swap(children);
+	std::vector<unsigned char>().swap(flags);
+	std::vector<long long>().swap(replacement);
+	std::vector<int>().swap(pending_uses);
+	changed_codes.clear();
+
+	std::vector<bool> reached = reachable(compressed, root);
+	num_nodes = std::count(reached.begin(), reached.end(), true);
+
+	std::vector<long double> sizes(root + 1, 1);
+	for(long long i=0; i <= root; i++)
+	{
+		if(compressed[i].first != -1) sizes[i] += sizes[compressed[i].first] + sizes[compressed[i].second];
+	}
+	tree_nodes = sizes[root];
+}
+
+size_t ProofCompression::size() const
+{
+	return num_nodes;
+}
+
+long double ProofCompression::tree_size() const
+{
+	return tree_nodes;
+}
+
+long long ProofCompression::regularized() const
+{
+	return num_regularized;
+}
+
+long long ProofCompression::lowered_units() const
+{
+	return units.size();
+}
+
+bool ProofCompression::compress(bool lower_units)
+{
+	collect_deletions(lower_units);
+	return rebuild();
+}
+
+void ProofCompression::collect_deletions(bool lower_units)
+{
+	const std::vector<dag_node>& nodes = dag.nodes();
+	long long n = dag.used_size();
+
+	children.assign(n, 0);
+	flags.assign(n, 0);
+	units.clear();
+	num_regularized = 0;
+
+	for(long long i=0; i < n; i++)
+	{
+		if(nodes[i].first == -1) continue;
+		children[nodes[i].first]++;
+		children[nodes[i].second]++;
+	}
+
+	if(lower_units)
+	{
+		for(long long i=n - 2; i >= 0; i--)
+		{
+			if(children[i] < 2 || nodes[i].clause->width() != 1) continue;
+			flags[i] |= lowered;
+			units.push_back(i);
+		}
+	}
+
+	// The safe literals of a node are complete once all of its children are
+	// done, which in reverse topological order is when the node comes up.
+	// Nothing is safe for the root. Lowered units are resolved with the root in
+	// the end, which makes their own literal safe
+	std::unordered_map<long long, std::vector<int> > safe_literals;
+	safe_literals[n - 1];
+
+	for(long long i=n - 1; i >= 0; i--)
+	{
+		std::vector<int> safe;
+		auto it = safe_literals.find(i);
+		if(it != safe_literals.end())
+		{
+			safe.swap(it->second);
+			safe_literals.erase(it);
+		}
+		else if( ! (flags[i] & lowered))
+		{
+			flags[i] |= unreached;
+			continue;
+		}
+
+		const dag_node& node = nodes[i];
+		if(flags[i] & lowered) safe.assign(1, literal_code(node.clause->literals()[0]));
+		if(node.first == -1) continue;
+
+		int pivot = pivot_code(node, nodes);
+		bool keep_first = true, keep_second = true;
+		bool first_lowered = flags[node.first] & lowered, second_lowered = flags[node.second] & lowered;
+
+		// The child of a lowered unit is replaced by its other parent, which
+		// keeps the complement of the unit until it is resolved with the root
+		if(first_lowered != second_lowered)
+		{
+			keep_first = ! first_lowered;
+			keep_second = ! second_lowered;
+		}
+		else if( ! first_lowered && contains(safe, pivot))
+		{
+			keep_second = false;
+			num_regularized++;
+		}
+		else if( ! first_lowered && contains(safe, pivot ^ 1))
+		{
+			keep_first = false;
+			num_regularized++;
+		}
+
+		if( ! keep_first) flags[i] |= delete_first;
+		if( ! keep_second) flags[i] |= delete_second;
+		if(keep_first) add_safe_literals(safe_literals, node.first, safe, pivot);
+		if(keep_second) add_safe_literals(safe_literals, node.second, safe, pivot ^ 1);
+	}
+}
+
+bool ProofCompression::rebuild()
+{
+	const std::vector<dag_node>& nodes = dag.nodes();
+	long long n = dag.used_size();
+
+	compressed.clear();
+	changed_codes.clear();
+	pending_uses.clear();
+	replacement.assign(n, -1);
+	failed = false;
+
+	for(long long i=0; i < n; i++)
+	{
+		const dag_node& node = nodes[i];
+		long long r;
+
+		if(flags[i] & unreached) r = -1;
+		else if(node.first == -1)
+		{
+			r = compressed.size();
+			compressed.push_back(compressed_node{node.clause, -1, -1, 0});
+			pending_uses.push_back(0);
+		}
+		else if(flags[i] & delete_first) r = replacement[node.second];
+		else if(flags[i] & delete_second) r = replacement[node.first];
+		else
+		{
+			long long first = replacement[node.first], second = replacement[node.second];
+			int pivot = pivot_code(node, nodes);
+
+			if(compressed[first].clause == nodes[node.first].clause && compressed[second].clause == nodes[node.second].clause)
+			{
+				r = compressed.size();
+				compressed.push_back(compressed_node{node.clause, first, second, pivot});
+				pending_uses.push_back(0);
+			}
+			// A parent that lost the pivot replaces the resolution
+			else if( ! contains(codes(first), pivot)) r = first;
+			else if( ! contains(codes(second), pivot ^ 1)) r = second;
+			else r = add_resolvent(first, second, pivot);
+		}
+
+		replacement[i] = r;
+		// Lowered units and the root are used once more in the end
+		if(r != -1) pending_uses[r] += children[i] + ((flags[i] & lowered) || i == n - 1 ? 1 : 0);
+
+		if(node.first != -1)
+		{
+			release(replacement[node.first]);
+			release(replacement[node.second]);
+		}
+	}
+
+	root = replacement[n - 1];
+	for(long long u : units)
+	{
+		long long unit = replacement[u];
+		int code = literal_code(nodes[u].clause->literals()[0]);
+
+		if(contains(codes(root), code ^ 1) && contains(codes(unit), code))
+		{
+			long long resolvent = add_resolvent(unit, root, code);
+			pending_uses[resolvent]++;
+			release(root);
+			root = resolvent;
+		}
+		release(unit);
+	}
+
+	// The compressed proof may only derive a subset of the original root
+	std::vector<int> derived = codes(root), original = clause_codes(nodes[n - 1].clause);
+	if( ! std::includes(original.begin(), original.end(), derived.begin(), derived.end())) failed = true;
+
+	return ! failed;
+}
+
+long long ProofCompression::add_resolvent(long long first, long long second, int pivot)
+{
+	std::vector<int> resolvent;
+	if( ! resolve_codes(codes(first), codes(second), pivot, resolvent)) failed = true;
+
+	long long r = compressed.size();
+	compressed.push_back(compressed_node{nullptr, first, second, pivot});
+	pending_uses.push_back(0);
+	changed_codes[r].swap(resolvent);
+	return r;
+}
+
+std::vector<int> ProofCompression::codes(long long node) const
+{
+	if(compressed[node].clause != nullptr) return clause_codes(compressed[node].clause);
+	return changed_codes.at(node);
+}
+
+void ProofCompression::release(long long node)
+{
+	if(node != -1 && --pending_uses[node] == 0) changed_codes.erase(node);
+}
+
+void ProofCompression::write_json(std::ostream& out) const
+{
+	out << "{\"compression\": {\"size\": " << dag.used_size() << ", \"compressed_size\": " << num_nodes
+		<< ", \"compressed_tree_size\": \"" << tree_nodes << "\", \"regularized\": " << num_regularized
+		<< ", \"lowered_units\": " << units.size() << "}}" << std::endl;
+}
+
+void ProofCompression::write_tracecheck(std::ostream& out, proof_format format) const
+{
+	TracecheckWriter writer(out, format);
+	std::vector<bool> reached = reachable(compressed, root);
+
+	// The literals of changed clauses are resolved again, and kept until their
+	// last child is written
+	std::vector<long long> ids(root + 1, 0);
+	std::vector<int> uses(root + 1, 0);
+	for(long long i=0; i <= root; i++)
+	{
+		if( ! reached[i] || compressed[i].first == -1) continue;
+		uses[compressed[i].first]++;
+		uses[compressed[i].second]++;
+	}
+
+	std::unordered_map<long long, std::vector<int> > changed;
+	auto lookup = [&](long long node) -> std::vector<int>
+	{
+		if(compressed[node].clause != nullptr) return clause_codes(compressed[node].clause);
+		return changed.at(node);
+	};
+
+	long long next_id = 1;
+	for(long long i=0; i <= root; i++)
+	{
+		if( ! reached[i]) continue;
+		const compressed_node& node = compressed[i];
+		ids[i] = next_id++;
+
+		if(node.clause != nullptr)
+		{
+			writer.step(ids[i], node.clause->literals(), node.first == -1 ? 0 : ids[node.first], node.first == -1 ? 0 : ids[node.second]);
+		}
+		else
+		{
+			std::vector<int> resolvent;
+			resolve_codes(lookup(node.first), lookup(node.second), node.pivot, resolvent);
+			writer.step(ids[i], code_literals(resolvent), ids[node.first], ids[node.second]);
+			if(uses[i] > 0) changed[i].swap(resolvent);
+		}
+
+		if(node.first != -1)
+		{
+			if(--uses[node.first] == 0) changed.erase(node.first);
+			if(--uses[node.second] == 0) changed.erase(node.second);
+		}
+	}
+}
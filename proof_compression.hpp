@@ -0,0 +1,82 @@
+#pragma once
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "proof_dag.hpp"
+#include "proof_export.hpp"
+
+// A node of the compressed proof. Parents are indices into the compressed
+// nodes (-1 for axioms). Nodes whose clause did not change point to the
+// original clause, the literals of all others are resolved again when needed
+struct compressed_node
+{
+	const Clause* clause;
+	long long first, second;
+	// Literal code (2 * variable + negated) of the pivot in the first parent
+	int pivot;
+};
+
+// ProofCompression shrinks the used part of a ProofDag with two techniques
+// that both delete edges of the proof:
+//
+// * RecyclePivots (with intersection): a literal is safe for a node if it is
+//   resolved away on every path from the node to the root. A resolution whose
+//   pivot literal is safe is redundant, and the node is replaced by the parent
+//   that contains the safe literal
+// * LowerUnits: unit clauses with more than one child are taken out of the
+//   proof and resolved with the root once instead, last used first
+//
+// Both take two linear passes over the DAG: one in reverse topological order
+// that collects safe literals (which are kept for pending nodes only) and
+// decides the deletions, and one in topological order that rebuilds the proof,
+// replacing a resolution by a parent whenever that parent no longer contains
+// the pivot. Only the literals of changed clauses are computed, and they are
+// freed once every child is rebuilt
+//
+// The result is checked to refute what the original did. Should lowering units
+// break that, compression is repeated without it
+class ProofCompression
+{
+public:
+	ProofCompression(const ProofDag& dag);
+
+	// Nodes of the compressed proof, counted like ProofDag::used_size
+	size_t size() const;
+	// Size of its tree-like expansion, like the tree_copy_cost statistic
+	long double tree_size() const;
+	// Resolutions removed because their pivot was safe
+	long long regularized() const;
+	long long lowered_units() const;
+
+	void write_json(std::ostream& out) const;
+	void write_tracecheck(std::ostream& out, proof_format format) const;
+
+private:
+	bool compress(bool lower_units);
+	void collect_deletions(bool lower_units);
+	bool rebuild();
+	long long add_resolvent(long long first, long long second, int pivot);
+	std::vector<int> codes(long long node) const;
+	void release(long long node);
+
+	const ProofDag& dag;
+
+	// Per node of the DAG
+	std::vector<int> children;
+	std::vector<unsigned char> flags;
+	std::vector<long long> replacement;
+	// Lowered units, root side first
+	std::vector<long long> units;
+	long long num_regularized;
+
+	std::vector<compressed_node> compressed;
+	long long root;
+	// Literal codes of changed clauses that are still needed, and how many
+	// more times
+	std::unordered_map<long long, std::vector<int> > changed_codes;
+	std::vector<int> pending_uses;
+	bool failed;
+
+	size_t num_nodes;
+	long double tree_nodes;
+};
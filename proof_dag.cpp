@@ -0,0 +1,103 @@
+#include "proof_dag.hpp"
+
+ProofDag::ProofDag(const clause_ref& root, bool _stop_at_used) : stop_at_used(_stop_at_used)
+{
+	add_derivation(root.get());
+	num_used = node_list.size();
+}
+
+void ProofDag::add_unused(const SolverShadowBase& solver)
+{
+	// Same starting points as the unused traversal of ResolutionGraph
+	if(solver.first_learned_index == -1) return;
+
+	for(size_t i=solver.first_learned_index; i < solver.clauses.size(); i++)
+	{
+		const Clause* c = solver.clauses[i].get();
+		if(c == nullptr || ! c->is_learned() || shared_index.count(c) > 0) continue;
+		add_derivation(c);
+	}
+}
+
+long long ProofDag::add_derivation(const Clause* root)
+{
+	// Iterative post-order traversal, since proofs are far too deep for
+	// recursion. The indices of finished nodes are kept on a separate stack
+	// until their child is finished
+	typedef std::pair<const Clause*, bool> frame;
+	std::vector<frame> stack;
+	std::vector<long long> finished;
+	stack.push_back(frame(root, false));
+
+	while( ! stack.empty())
+	{
+		frame f = stack.back();stack.pop_back();
+		const Clause* clause = f.first;
+
+		if(f.second)
+		{
+			long long second = finished.back();finished.pop_back();
+			long long first = finished.back();finished.pop_back();
+			finished.push_back(add_node(clause, first, second));
+			continue;
+		}
+
+		if(clause->is_learned() || clause->is_axiom())
+		{
+			auto it = shared_index.find(clause);
+			if(it != shared_index.end())
+			{
+				finished.push_back(it->second);
+				continue;
+			}
+		}
+
+		if(clause->is_axiom() || (stop_at_used && clause->is_learned() && clause->refutation_mark() > 0))
+		{
+			finished.push_back(add_node(clause, -1, -1));
+			continue;
+		}
+
+		// The first parent is pushed last, so that it is finished first
+		std::pair<clause_ref, clause_ref> parents = clause->resolved_from();
+		stack.push_back(frame(clause, true));
+		stack.push_back(frame(parents.second.get(), false));
+		stack.push_back(frame(parents.first.get(), false));
+	}
+
+	assert(finished.size() == 1);
+	return finished.back();
+}
+
+long long ProofDag::add_node(const Clause* clause, long long first, long long second)
+{
+	long long index = node_list.size();
+	node_list.push_back(dag_node{clause, first, second});
+	if(clause->is_learned() || clause->is_axiom()) shared_index[clause] = index;
+	return index;
+}
+
+const std::vector<dag_node>& ProofDag::nodes() const
+{
+	return node_list;
+}
+
+size_t ProofDag::size() const
+{
+	return node_list.size();
+}
+
+size_t ProofDag::used_size() const
+{
+	return num_used;
+}
+
+bool ProofDag::used(long long node) const
+{
+	return node < (long long) num_used;
+}
+
+long long ProofDag::root() const
+{
+	return num_used - 1;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include "clause.hpp"
+#include "solver_shadow.hpp"
+
+// A node of the flattened proof. Parents are indices into ProofDag::nodes()
+// (-1 for axioms)
+struct dag_node
+{
+	const Clause* clause;
+	long long first, second;
+};
+
+// ProofDag is a flat copy of the part of the clause DAG that is reachable from
+// a root clause, in topological order (the parents of a node always come
+// before it, and the root is last). Learned clauses and axioms are shared
+// between their uses, while intermediate clauses, which are only created for a
+// single resolution chain, appear once per use as in ResolutionGraph
+//
+// add_unused appends the learned clauses that the root does not depend on
+// (and their derivations), so the used nodes are always the prefix
+// [0, used_size())
+//
+// With stop_at_used, learned clauses that an earlier refutation used (see
+// Clause::refutation_mark) become leaves like axioms, so that only the part
+// of the proof that is new to this refutation is copied
+//
+// The nodes point into the clauses, which therefore have to outlive the DAG
+class ProofDag
+{
+public:
+	ProofDag(const clause_ref& root, bool stop_at_used = false);
+	void add_unused(const SolverShadowBase& solver);
+
+	const std::vector<dag_node>& nodes() const;
+	size_t size() const;
+	size_t used_size() const;
+	bool used(long long node) const;
+	long long root() const;
+
+private:
+	long long add_derivation(const Clause* root);
+	long long add_node(const Clause* clause, long long first, long long second);
+
+	std::vector<dag_node> node_list;
+	std::unordered_map<const Clause*, long long> shared_index;
+	size_t num_used;
+	bool stop_at_used;
+};
@@ -0,0 +1,336 @@
+#include "proof_events.hpp"
+#include "profiler.hpp"
+#include "timeline.hpp"
+#include "histograms.hpp"
+#include "windows.hpp"
+#include "snapshot.hpp"
+
+template<ignore_mode mode>
+ProofEvents<mode>::ProofEvents() : passes(all_passes), verifying(false), derivation_steps(0), derivation_skipped(0), derivation_minimization(minimization_none), learned_log(nullptr), derivation_start(0), interval_start(0), interval_learned(0)
+{
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_num_vars(int num_vars)
+{
+	counted.events++;
+	solver.num_vars(num_vars);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_input_clause(int cref, const std::vector<Literal>& literals)
+{
+	PROFILE_SCOPE(phase_input_clause);
+	counted.events++;
+	solver.add_clause(std::make_shared<Clause>(Clause(literals)), cref);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_decide(const Literal& l)
+{
+	PROFILE_SCOPE(phase_decide);
+	counted.events++;
+	solver.decide(l);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_propagate(const Literal& l, int cref)
+{
+	PROFILE_SCOPE(phase_propagate);
+	counted.events++;
+	solver.propagate(l, cref);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_propagate_unit(const Literal& l)
+{
+	PROFILE_SCOPE(phase_propagate);
+	counted.events++;
+	solver.propagate(l);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_analyze(int cref, std::vector<Literal> skipped)
+{
+	PROFILE_SCOPE(phase_analyze);
+	counted.events++;
+	clause_ref c = solver.clause_by_cref(cref);
+	if(timeline_active && remaining == nullptr) derivation_start = timeline_now();
+	if(histograms_active) histogram_add(histogram_skipped_per_analyze, skipped.size());
+	derivation_steps++;
+	derivation_skipped += skipped.size();
+
+	if constexpr(mode != none)
+	{
+		if(skipped.size() > 0) c = solver.skip(cref, skipped);
+	}
+
+	if(remaining == nullptr)
+	{
+		remaining = c;
+	}
+	else
+	{
+		remaining = Clause::resolve(remaining, c);
+	}
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_minimize(const std::vector<Literal>& removed)
+{
+	PROFILE_SCOPE(phase_minimize);
+	counted.events++;
+	if(histograms_active) histogram_add(histogram_minimize_removed, removed.size());
+	derivation_minimization = minimization_basic;
+	remaining = solver.minimize(remaining, removed);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_minimize_full(const std::vector<Literal>& removed)
+{
+	PROFILE_SCOPE(phase_minimize);
+	counted.events++;
+	if(histograms_active) histogram_add(histogram_minimize_removed, removed.size());
+	derivation_minimization = minimization_full;
+	remaining = solver.minimize_full(remaining, removed);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_learn(int cref, const std::vector<Literal>& literals)
+{
+	PROFILE_SCOPE(phase_learn);
+	counted.events++;
+	if constexpr(mode != none)
+	{
+		if(verifying && remaining->fingerprint() != Clause::fingerprint(literals))
+		{
+			mismatch = "Learned clause " + std::to_string(cref) + " (" + Clause(literals).to_str() + ") does not match the derivation (" + remaining->to_str() + ")";
+			return;
+		}
+
+		Clause should_be(literals);
+		assert(should_be == *remaining.get());
+	}
+
+	//if(remaining->is_axiom()) std::cout << "WARNING: learned using only conflict clause" << std::endl;
+	counted.learned++;
+	end_derivation(cref);
+	solver.add_clause(std::make_shared<const Clause>(Clause(*remaining, true, counted.learned)), cref);
+	remaining = nullptr;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_learn_unit(const Literal& l)
+{
+	PROFILE_SCOPE(phase_learn);
+	counted.events++;
+	if constexpr(mode != none)
+	{
+		if(verifying && remaining->fingerprint() != Clause::fingerprint(l))
+		{
+			mismatch = "Learned unit " + l.to_str() + " does not match the derivation (" + remaining->to_str() + ")";
+			return;
+		}
+
+		assert(remaining->unit());
+		assert(remaining->first_literal() == l);
+	}
+
+	counted.learned++;
+	end_derivation(-1);
+	solver.add_unit(std::make_shared<const Clause>(Clause(*remaining, true, counted.learned)), l);
+	remaining = nullptr;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_backtrack(int level)
+{
+	PROFILE_SCOPE(phase_backtrack);
+	counted.events++;
+	solver.backtrack(level);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_restart()
+{
+	PROFILE_SCOPE(phase_restart);
+	counted.events++;
+	counted.restarts++;
+	end_restart_interval();
+	solver.restart();
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_remove(int cref)
+{
+	PROFILE_SCOPE(phase_remove);
+	counted.events++;
+	solver.remove_clause(cref);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::on_relocate(const std::vector<std::pair<int, int> >& moves)
+{
+	PROFILE_SCOPE(phase_relocate);
+	counted.events++;
+	counted.relocations++;
+	TimelineSpan span("relocation", "replay", "moves", moves.size());
+	solver.relocate(moves);
+}
+
+template<ignore_mode mode>
+ResolutionGraph ProofEvents<mode>::on_final_conflict(int cref, bool build_graph, DotWriter* dot)
+{
+	end_restart_interval();
+	TimelineSpan span("graph_build", "graph");
+	return ResolutionGraph(solver, cref, build_graph, dot, &marks, passes);
+}
+
+template<ignore_mode mode>
+const SolverShadow<mode>& ProofEvents<mode>::shadow() const
+{
+	return solver;
+}
+
+template<ignore_mode mode>
+const event_counts& ProofEvents<mode>::counts() const
+{
+	return counted;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::verify(bool enabled)
+{
+	verifying = enabled;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::log_learned(LearnedLog* log)
+{
+	learned_log = log;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::reclaim_removed(bool enabled)
+{
+	solver.reclaim_removed(enabled);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::compact_clauses(bool enabled)
+{
+	solver.compact_clauses(enabled);
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::run_passes(analysis_passes _passes)
+{
+	passes = required_passes(_passes);
+	marks.passes = passes;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::save(std::ostream& out, long long offset, long long lines) const
+{
+	assert(remaining == nullptr);
+
+	snapshot_header header;
+	header.mode = mode;
+	header.offset = offset;
+	header.lines = lines;
+	header.events = counted.events;
+	header.learned = counted.learned;
+	header.restarts = counted.restarts;
+	header.relocations = counted.relocations;
+	write_snapshot(out, solver, marks, header);
+}
+
+template<ignore_mode mode>
+bool ProofEvents<mode>::load(std::istream& in, long long& offset, long long& lines)
+{
+	snapshot_header header;
+	if( ! read_snapshot(in, solver, marks, header) || header.mode != mode) return false;
+
+	// Without the unused pass removed clauses are reclaimed, so it cannot be
+	// added later. Later refutations also build on the tree copy counts of
+	// earlier ones
+	if((passes & ~marks.passes & pass_unused) != 0) return false;
+	if(marks.refutations > 0 && (passes & ~marks.passes & pass_copy_cost) != 0) return false;
+	marks.passes &= passes;
+
+	offset = header.offset;
+	lines = header.lines;
+	counted.events = header.events;
+	counted.learned = header.learned;
+	counted.restarts = header.restarts;
+	counted.relocations = header.relocations;
+	return true;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::verify_refutation(const ResolutionGraph& graph)
+{
+	// Only the negations of assumptions may remain
+	clause_ref refutation = graph.refutation();
+	bool refuted = refutation->fingerprint() == Clause::fingerprint(refutation->literals());
+	for(const Literal& l : refutation->literals())
+	{
+		refuted = refuted && solver.decided(Literal(l.variable(), ! l.negated()));
+	}
+
+	if( ! refuted)
+	{
+		mismatch = "The final conflict resolved to (" + refutation->to_str() + ") instead of the empty clause or negated assumptions";
+	}
+}
+
+template<ignore_mode mode>
+bool ProofEvents<mode>::consistent() const
+{
+	return mismatch.empty();
+}
+
+template<ignore_mode mode>
+const std::string& ProofEvents<mode>::inconsistency() const
+{
+	return mismatch;
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::end_derivation(int cref)
+{
+	if(histograms_active)
+	{
+		histogram_add(histogram_learned_width, remaining->width());
+		histogram_add(histogram_chain_length, derivation_steps);
+	}
+	if(window_width > 0) window_learned(counted.learned, counted.restarts, remaining->width());
+	if(learned_log) learned_log->record(learned_record{counted.learned, cref, derivation_steps, derivation_skipped, derivation_minimization}, *remaining);
+
+	derivation_steps = 0;
+	derivation_skipped = 0;
+	derivation_minimization = minimization_none;
+
+	if( ! timeline_active) return;
+
+	long long now = timeline_now();
+	if(timeline_keeps_derivation(remaining->width(), now - derivation_start))
+	{
+		timeline_record("learned_derivation", "analyze", derivation_start, now, "width", remaining->width());
+	}
+}
+
+template<ignore_mode mode>
+void ProofEvents<mode>::end_restart_interval()
+{
+	if( ! timeline_active) return;
+
+	long long now = timeline_now();
+	timeline_record("restart_interval", "replay", interval_start, now, "learned", counted.learned - interval_learned);
+	interval_start = now;
+	interval_learned = counted.learned;
+}
+
+template class ProofEvents<none>;
+template class ProofEvents<learn>;
+template class ProofEvents<resolve_unit>;
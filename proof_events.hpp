@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <string>
+#include <istream>
+#include <ostream>
+#include "literal.hpp"
+#include "clause.hpp"
+#include "solver_shadow.hpp"
+#include "resolution_graph.hpp"
+#include "learned_log.hpp"
+
+// Number of events reported so far, for progress reporting
+struct event_counts
+{
+	long long events = 0;
+	long long learned = 0;
+	long long restarts = 0;
+	long long relocations = 0;
+};
+
+// ProofEvents is the in-process interface to the solver shadow. Each method
+// corresponds to one kind of trace line, so an instrumented solver can link
+// against the library and report its steps directly instead of printing a
+// trace (the text trace itself is replayed through this class by TraceReader)
+//
+// Events have to arrive in the order the solver performs them. A conflict
+// analysis is reported as on_analyze for the conflict clause followed by
+// on_analyze for each reason clause in resolution order, optionally
+// on_minimize/on_minimize_full and on_backtrack, and finally on_learn or
+// on_learn_unit
+template<ignore_mode mode>
+class ProofEvents
+{
+public:
+	ProofEvents();
+
+	// NV
+	void on_num_vars(int num_vars);
+	// I
+	void on_input_clause(int cref, const std::vector<Literal>& literals);
+	// D
+	void on_decide(const Literal& l);
+	// P
+	void on_propagate(const Literal& l, int cref);
+	// PU, propagation of a learned unit
+	void on_propagate_unit(const Literal& l);
+
+	// U (and the S lines following it), where skipped are the literals of
+	// the clause that were assigned at level 0 and ignored by the solver
+	void on_analyze(int cref, std::vector<Literal> skipped);
+	// MNM
+	void on_minimize(const std::vector<Literal>& removed);
+	// MNM2
+	void on_minimize_full(const std::vector<Literal>& removed);
+	// L, where literals is the clause the solver learned
+	void on_learn(int cref, const std::vector<Literal>& literals);
+	// LU
+	void on_learn_unit(const Literal& l);
+
+	// B
+	void on_backtrack(int level);
+	// RS
+	void on_restart();
+	// R
+	void on_remove(int cref);
+	// M ... RD, where moves are (from, to) cref pairs
+	void on_relocate(const std::vector<std::pair<int, int> >& moves);
+
+	// C, resolves the final conflict down to the empty clause and analyzes
+	// the resulting refutation (optionally streaming it to dot). An
+	// incremental solver reports one per unsatisfiable call, and the trace
+	// continues after it. Each refutation only analyzes the part of the proof
+	// earlier ones did not (see refutation_marks), with the passes given to
+	// run_passes
+	ResolutionGraph on_final_conflict(int cref, bool build_graph, DotWriter* dot = nullptr);
+
+	const SolverShadow<mode>& shadow() const;
+	const event_counts& counts() const;
+
+	// Verification compares the fingerprints of the clauses the solver
+	// reports with L and LU against the reconstructed ones, and (through
+	// verify_refutation) checks that the final conflict resolved to the empty
+	// clause, or to negated assumptions. Unlike the asserts, it stays on in
+	// release builds. Without ignoring (mode none) learned clauses keep their
+	// level 0 literals, so only the refutation is checked
+	void verify(bool enabled);
+	// Writes a record of every learned clause to log, nullptr to stop
+	void log_learned(LearnedLog* log);
+	// See SolverShadowBase::reclaim_removed
+	void reclaim_removed(bool enabled);
+	// See SolverShadowBase::compact_clauses
+	void compact_clauses(bool enabled);
+	// Selects the analyses of every refutation (all by default). Has to be
+	// called before load, which rejects snapshots taken without the unused
+	// pass, or whose earlier refutations skipped the copy cost pass, when
+	// they are selected
+	void run_passes(analysis_passes passes);
+
+	// Writes the shadow and the event counts as a snapshot (see snapshot.hpp)
+	// taken after the given bytes and lines of the trace. Only valid between
+	// conflict analyses
+	void save(std::ostream& out, long long offset, long long lines) const;
+	// Restores a snapshot of the same ignore mode into fresh events, and
+	// returns where in the trace to continue (false if it is not valid)
+	bool load(std::istream& in, long long& offset, long long& lines);
+	void verify_refutation(const ResolutionGraph& graph);
+	// False after the first mismatch, which inconsistency() describes
+	bool consistent() const;
+	const std::string& inconsistency() const;
+
+private:
+	// Records the derivation of remaining in the histograms, the learned
+	// clause log and on the timeline, if it is slow or wide enough
+	void end_derivation(int cref);
+	void end_restart_interval();
+
+	SolverShadow<mode> solver;
+	refutation_marks marks;
+	analysis_passes passes;
+	event_counts counted;
+
+	bool verifying;
+	std::string mismatch;
+
+	// Resolution steps (U), skipped literals and minimization of the current
+	// derivation
+	long long derivation_steps;
+	long long derivation_skipped;
+	minimization_kind derivation_minimization;
+	LearnedLog* learned_log;
+
+	// Start of the current derivation and restart interval on the timeline
+	long long derivation_start;
+	long long interval_start;
+	long long interval_learned;
+
+	// The clause currently being learned
+	clause_ref remaining;
+};
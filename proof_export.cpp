@@ -0,0 +1,67 @@
+#include "proof_export.hpp"
+
+namespace
+{
+	void write_varint(BufferedWriter& writer, unsigned long long value)
+	{
+		char bytes[10];
+		int length = 0;
+
+		while(value >= 0x80)
+		{
+			bytes[length++] = (char) ((value & 0x7f) | 0x80);
+			value >>= 7;
+		}
+		bytes[length++] = (char) value;
+
+		writer.write(bytes, length);
+	}
+}
+
+TracecheckWriter::TracecheckWriter(std::ostream& out, proof_format _format) : writer(out), format(_format)
+{
+}
+
+void TracecheckWriter::step(long long id, const std::vector<Literal>& literals, long long first, long long second)
+{
+	if(format == tracecheck_binary)
+	{
+		write_varint(writer, id);
+		for(const Literal& l : literals)
+		{
+			write_varint(writer, 2 * ((unsigned long long) l.variable() + 1) + (l.negated() ? 1 : 0));
+		}
+		writer << '\0';
+
+		if(first != 0)
+		{
+			write_varint(writer, first);
+			write_varint(writer, second);
+		}
+		writer << '\0';
+		return;
+	}
+
+	writer << id << ' ';
+	for(const Literal& l : literals)
+	{
+		if(l.negated()) writer << '-';
+		writer << l.variable() + 1 << ' ';
+	}
+	writer << "0 ";
+
+	if(first != 0) writer << first << ' ' << second << ' ';
+	writer << "0\n";
+}
+
+void write_tracecheck(const ProofDag& dag, std::ostream& out, proof_format format)
+{
+	TracecheckWriter writer(out, format);
+	const std::vector<dag_node>& nodes = dag.nodes();
+
+	for(size_t i=0; i < dag.used_size(); i++)
+	{
+		const dag_node& node = nodes[i];
+		writer.step(i + 1, node.clause->literals(), node.first + 1, node.second + 1);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <ostream>
+#include <vector>
+#include "buffered_writer.hpp"
+#include "proof_dag.hpp"
+
+enum proof_format { tracecheck_text = 0, tracecheck_binary };
+
+// Writes the used part of the proof as a resolution proof in TraceCheck format, one binary
+// resolution step per line:
+//
+//   <id> <literals> 0 <antecedent ids> 0
+//
+// Ids are the DAG indices plus one, so antecedents always come first, and
+// variables are shifted by one to follow the DIMACS convention (minisat
+// numbers them from 0). Axioms have no antecedents and the last line is the
+// empty clause
+//
+// The binary variant has the same structure, but every number is written as
+// an unsigned LEB128 varint and literals are encoded as
+// 2 * (variable + 1) + negated, as in binary DRAT. The zeros terminating the
+// literal and antecedent lists are single zero bytes
+void write_tracecheck(const ProofDag& dag, std::ostream& out, proof_format format);
+
+// Writes a proof in the same format one step at a time, for proofs that are
+// not a ProofDag. Ids start at 1 and the antecedents of axioms are 0
+class TracecheckWriter
+{
+public:
+	TracecheckWriter(std::ostream& out, proof_format _format);
+
+	void step(long long id, const std::vector<Literal>& literals, long long first, long long second);
+
+private:
+	BufferedWriter writer;
+	proof_format format;
+};
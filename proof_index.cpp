@@ -0,0 +1,122 @@
+#include "proof_index.hpp"
+#include "buffered_writer.hpp"
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+	template<class T>
+	void write_raw(BufferedWriter& writer, const T& value)
+	{
+		writer.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+}
+
+void write_proof_index(const ProofDag& dag, std::ostream& out)
+{
+	const std::vector<dag_node>& nodes = dag.nodes();
+
+	uint64_t num_literals = 0;
+	for(const dag_node& node : nodes) num_literals += node.clause->width();
+
+	index_header header;
+	std::memcpy(header.magic, proof_index_magic, sizeof(header.magic));
+	header.num_nodes = nodes.size();
+	header.num_used = dag.used_size();
+	header.root = dag.root() + 1;
+	header.num_literals = num_literals;
+	header.nodes_offset = sizeof(index_header);
+	header.literal_offsets_offset = header.nodes_offset + nodes.size() * sizeof(index_node);
+	header.literals_offset = header.literal_offsets_offset + (nodes.size() + 1) * sizeof(uint64_t);
+
+	BufferedWriter writer(out);
+	write_raw(writer, header);
+
+	for(size_t i=0; i < nodes.size(); i++)
+	{
+		const Clause* clause = nodes[i].clause;
+		index_node node;
+		node.first = nodes[i].first + 1;
+		node.second = nodes[i].second + 1;
+		node.pivot = clause->is_resolvent() ? clause->removed_variable().value() : -1;
+		node.width = clause->width();
+		node.flags = 0;
+		if(clause->is_learned()) node.flags |= node_learned;
+		if(clause->is_axiom()) node.flags |= node_axiom;
+		if(dag.used(i)) node.flags |= node_used;
+		node.reserved = 0;
+		write_raw(writer, node);
+	}
+
+	uint64_t offset = 0;
+	for(const dag_node& node : nodes)
+	{
+		write_raw(writer, offset);
+		offset += node.clause->width();
+	}
+	write_raw(writer, offset);
+
+	for(const dag_node& node : nodes)
+	{
+		for(const Literal& l : node.clause->literals())
+		{
+			uint32_t encoded = 2 * (uint32_t) l.variable() + (l.negated() ? 1 : 0);
+			write_raw(writer, encoded);
+		}
+	}
+}
+
+ProofIndex::ProofIndex(const std::string& path) : mapping(nullptr), mapping_size(0), head(nullptr)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd == -1) return;
+
+	struct stat st;
+	if(fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(index_header))
+	{
+		mapping_size = st.st_size;
+		mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(mapping == MAP_FAILED) mapping = nullptr;
+	}
+	close(fd);
+	if(mapping == nullptr) return;
+
+	const char* base = static_cast<const char*>(mapping);
+	const index_header* h = reinterpret_cast<const index_header*>(base);
+	if(std::memcmp(h->magic, proof_index_magic, sizeof(h->magic)) != 0) return;
+	if(h->literals_offset + h->num_literals * sizeof(uint32_t) > mapping_size) return;
+
+	head = h;
+	node_table = reinterpret_cast<const index_node*>(base + h->nodes_offset);
+	literal_offsets = reinterpret_cast<const uint64_t*>(base + h->literal_offsets_offset);
+	literal_table = reinterpret_cast<const uint32_t*>(base + h->literals_offset);
+}
+
+ProofIndex::~ProofIndex()
+{
+	if(mapping != nullptr) munmap(mapping, mapping_size);
+}
+
+bool ProofIndex::valid() const
+{
+	return head != nullptr;
+}
+
+const index_header& ProofIndex::header() const
+{
+	return *head;
+}
+
+const index_node& ProofIndex::node(uint64_t id) const
+{
+	return node_table[id - 1];
+}
+
+const uint32_t* ProofIndex::literals(uint64_t id) const
+{
+	return literal_table + literal_offsets[id - 1];
+}
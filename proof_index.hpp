@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "proof_dag.hpp"
+
+// On-disk layout of the proof index. The file is written in native byte
+// order and every section is 8-byte aligned, so that it can be memory mapped
+// and used without any parsing:
+//
+//   index_header
+//   index_node[num_nodes]
+//   uint64_t literal_offsets[num_nodes + 1]   (into the literal section)
+//   uint32_t literals[num_literals]           (2 * variable + negated)
+//
+// Node ids are 1-based like in the TraceCheck export (node i is stored at
+// position i - 1), parents always come before their children and the used
+// nodes are the prefix [1, num_used]
+const char proof_index_magic[8] = {'R', 'G', 'P', 'I', 'D', 'X', '0', '1'};
+
+enum index_node_flags : uint32_t
+{
+	node_learned = 1,
+	node_axiom = 2,
+	node_used = 4,
+};
+
+struct index_header
+{
+	char magic[8];
+	uint64_t num_nodes;
+	uint64_t num_used;
+	uint64_t root;
+	uint64_t num_literals;
+	uint64_t nodes_offset;
+	uint64_t literal_offsets_offset;
+	uint64_t literals_offset;
+};
+
+struct index_node
+{
+	// Parent ids, 0 for axioms
+	uint64_t first, second;
+	// The variable removed by the resolution, -1 for axioms
+	int32_t pivot;
+	uint32_t width;
+	uint32_t flags;
+	uint32_t reserved;
+};
+
+void write_proof_index(const ProofDag& dag, std::ostream& out);
+
+// Read-only view of a memory mapped proof index
+class ProofIndex
+{
+public:
+	ProofIndex(const std::string& path);
+	~ProofIndex();
+	ProofIndex(const ProofIndex&) = delete;
+	ProofIndex& operator=(const ProofIndex&) = delete;
+
+	// False if the file could not be mapped or is not a proof index
+	bool valid() const;
+
+	const index_header& header() const;
+	const index_node& node(uint64_t id) const;
+	const uint32_t* literals(uint64_t id) const;
+
+private:
+	void* mapping;
+	size_t mapping_size;
+	const index_header* head;
+	const index_node* node_table;
+	const uint64_t* literal_offsets;
+	const uint32_t* literal_table;
+};
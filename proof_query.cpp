@@ -0,0 +1,177 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <stdlib.h>
+#include "proof_index.hpp"
+
+// Answers questions about a proof written with --write-index, without
+// replaying the trace. Clauses are printed as TraceCheck lines (see
+// proof_export.hpp), so the output of "cone" is itself a valid proof
+
+void print_clause(const ProofIndex& index, uint64_t id)
+{
+	const index_node& node = index.node(id);
+	const uint32_t* literals = index.literals(id);
+
+	std::cout << id << " ";
+	for(uint32_t i=0; i < node.width; i++)
+	{
+		if(literals[i] & 1) std::cout << "-";
+		std::cout << (literals[i] >> 1) + 1 << " ";
+	}
+	std::cout << "0 ";
+	if(node.first != 0) std::cout << node.first << " " << node.second << " ";
+	std::cout << "0\n";
+}
+
+// Marks the derivation cone of the given clause. Parents always have smaller
+// ids, so a single pass downwards from the clause is enough
+std::vector<bool> mark_cone(const ProofIndex& index, uint64_t id)
+{
+	std::vector<bool> in_cone(id + 1, false);
+	in_cone[id] = true;
+
+	for(uint64_t i=id; i >= 1; i--)
+	{
+		if( ! in_cone[i]) continue;
+		const index_node& node = index.node(i);
+		if(node.first == 0) continue;
+		in_cone[node.first] = true;
+		in_cone[node.second] = true;
+	}
+
+	return in_cone;
+}
+
+void cone(const ProofIndex& index, uint64_t id)
+{
+	std::vector<bool> in_cone = mark_cone(index, id);
+	for(uint64_t i=1; i <= id; i++) if(in_cone[i]) print_clause(index, i);
+}
+
+void subproof_statistics(const ProofIndex& index, uint64_t id)
+{
+	std::vector<bool> in_cone = mark_cone(index, id);
+
+	long long axioms = 0, learned = 0, intermediate = 0, max_width = 0;
+	std::vector<long long> depth(id + 1, 0);
+	// Number of paths from the clause, i.e. how many copies of each node a
+	// tree-like version of the subproof would contain
+	std::vector<long double> copies(id + 1, 0);
+	copies[id] = 1;
+	long double copy_cost = 0;
+
+	for(uint64_t i=id; i >= 1; i--)
+	{
+		if( ! in_cone[i]) continue;
+		const index_node& node = index.node(i);
+		copy_cost += copies[i];
+		if(node.first == 0) continue;
+		copies[node.first] += copies[i];
+		copies[node.second] += copies[i];
+	}
+
+	for(uint64_t i=1; i <= id; i++)
+	{
+		if( ! in_cone[i]) continue;
+		const index_node& node = index.node(i);
+
+		if(node.flags & node_axiom) axioms++;
+		else if(node.flags & node_learned) learned++;
+		else intermediate++;
+		max_width = std::max(max_width, (long long) node.width);
+
+		if(node.first != 0) depth[i] = 1 + std::max(depth[node.first], depth[node.second]);
+	}
+
+	std::cout << "{\"clause\": " << id << ", \"axioms\": " << axioms << ", \"learned\": " << learned
+		<< ", \"intermediate\": " << intermediate << ", \"max_width\": " << max_width
+		<< ", \"depth\": " << depth[id] << ", \"tree_copy_cost\": \"" << copy_cost << "\"}" << std::endl;
+}
+
+void top_widest(const ProofIndex& index, uint64_t k)
+{
+	typedef std::pair<uint32_t, uint64_t> entry;
+	std::priority_queue<entry, std::vector<entry>, std::greater<entry> > widest;
+
+	for(uint64_t i=1; i <= index.header().num_used; i++)
+	{
+		widest.push(entry(index.node(i).width, i));
+		if(widest.size() > k) widest.pop();
+	}
+
+	std::vector<entry> result;
+	while( ! widest.empty())
+	{
+		result.push_back(widest.top());
+		widest.pop();
+	}
+
+	for(auto it=result.rbegin(); it != result.rend(); it++) print_clause(index, it->second);
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 3)
+	{
+		std::cout << "Usage: " << argv[0] << " INDEX COMMAND [ARGUMENT]" << std::endl;
+		std::cout << "Commands:" << std::endl;
+		std::cout << "  info              summary of the index" << std::endl;
+		std::cout << "  clause ID         print a single clause" << std::endl;
+		std::cout << "  cone ID           print the derivation of a clause" << std::endl;
+		std::cout << "  stats ID          statistics of the subproof rooted at a clause" << std::endl;
+		std::cout << "  top-widest K      the K widest used clauses" << std::endl;
+		return 1;
+	}
+
+	ProofIndex index(argv[1]);
+	if( ! index.valid())
+	{
+		std::cout << "ERROR: " << argv[1] << " is not a proof index" << std::endl;
+		return 1;
+	}
+
+	std::string command = argv[2];
+	const index_header& header = index.header();
+
+	if(command == "info")
+	{
+		std::cout << "{\"nodes\": " << header.num_nodes << ", \"used\": " << header.num_used
+			<< ", \"root\": " << header.root << ", \"literals\": " << header.num_literals << "}" << std::endl;
+		return 0;
+	}
+
+	if(argc < 4)
+	{
+		std::cout << "ERROR: " << command << " requires an argument" << std::endl;
+		return 1;
+	}
+
+	uint64_t argument = strtoull(argv[3], nullptr, 10);
+
+	if(command == "top-widest")
+	{
+		top_widest(index, argument);
+		return 0;
+	}
+
+	if(argument < 1 || argument > header.num_nodes)
+	{
+		std::cout << "ERROR: Clause id must be between 1 and " << header.num_nodes << std::endl;
+		return 1;
+	}
+
+	if(command == "clause") print_clause(index, argument);
+	else if(command == "cone") cone(index, argument);
+	else if(command == "stats") subproof_statistics(index, argument);
+	else
+	{
+		std::cout << "ERROR: Unknown command " << command << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
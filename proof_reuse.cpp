@@ -0,0 +1,114 @@
+#include "proof_reuse.hpp"
+#include "histograms.hpp"
+#include <algorithm>
+
+namespace
+{
+	// Buckets as in histograms.hpp
+	void add_to_histogram(std::vector<long long>& histogram, int bucket)
+	{
+		if(histogram.size() <= (size_t) bucket) histogram.resize(bucket + 1, 0);
+		histogram[bucket]++;
+	}
+
+	void write_histogram(std::ostream& out, const std::vector<long long>& histogram)
+	{
+		out << "[";
+		for(size_t i=0; i < histogram.size(); i++) out << (i == 0 ? "" : ", ") << histogram[i];
+		out << "]";
+	}
+}
+
+ProofReuse::ProofReuse(const ProofDag& _dag) :
+	dag(_dag), node_copies(_dag.used_size(), 0), node_references(_dag.used_size(), 0), total(0)
+{
+	// Children come after their parents, so every node has received the
+	// copies of all its children once the pass reaches it
+	if(dag.used_size() > 0) node_copies[dag.root()] = 1;
+
+	for(long long i=dag.used_size() - 1; i >= 0; i--)
+	{
+		total += node_copies[i];
+
+		const dag_node& node = dag.nodes()[i];
+		if(node.first == -1) continue;
+
+		node_copies[node.first] += node_copies[i];
+		node_copies[node.second] += node_copies[i];
+		node_references[node.first]++;
+		node_references[node.second]++;
+	}
+}
+
+long double ProofReuse::tree_size() const
+{
+	return total;
+}
+
+long double ProofReuse::copies(long long node) const
+{
+	return node_copies[node];
+}
+
+long long ProofReuse::references(long long node) const
+{
+	return node_references[node];
+}
+
+std::vector<clause_reuse> ProofReuse::most_copied(size_t k) const
+{
+	std::vector<clause_reuse> shared;
+	for(size_t i=0; i < dag.used_size(); i++)
+	{
+		const Clause* clause = dag.nodes()[i].clause;
+		if(clause->is_learned() || clause->is_axiom()) shared.push_back(clause_reuse{(long long) i, node_copies[i], node_references[i]});
+	}
+
+	k = std::min(k, shared.size());
+	std::partial_sort(shared.begin(), shared.begin() + k, shared.end(), [](const clause_reuse& a, const clause_reuse& b)
+		{
+			return a.copies > b.copies || (a.copies == b.copies && a.node < b.node);
+		}
+	);
+	shared.resize(k);
+	return shared;
+}
+
+void ProofReuse::write_json(std::ostream& out, size_t top_k) const
+{
+	std::vector<long long> learned_copies, learned_references, axiom_copies, axiom_references;
+	for(size_t i=0; i < dag.used_size(); i++)
+	{
+		const Clause* clause = dag.nodes()[i].clause;
+		if(clause->is_learned())
+		{
+			add_to_histogram(learned_copies, log2_bucket_float(node_copies[i]));
+			add_to_histogram(learned_references, log2_bucket(node_references[i]));
+		}
+		else if(clause->is_axiom())
+		{
+			add_to_histogram(axiom_copies, log2_bucket_float(node_copies[i]));
+			add_to_histogram(axiom_references, log2_bucket(node_references[i]));
+		}
+	}
+
+	out << "{\"reuse\": {\"tree_size\": \"" << total << "\", ";
+	out << "\"learned_copies_log2\": ";
+	write_histogram(out, learned_copies);
+	out << ", \"learned_references_log2\": ";
+	write_histogram(out, learned_references);
+	out << ", \"axiom_copies_log2\": ";
+	write_histogram(out, axiom_copies);
+	out << ", \"axiom_references_log2\": ";
+	write_histogram(out, axiom_references);
+
+	out << ", \"most_copied\": [";
+	std::vector<clause_reuse> top = most_copied(top_k);
+	for(size_t i=0; i < top.size(); i++)
+	{
+		const Clause* clause = dag.nodes()[top[i].node].clause;
+		out << (i == 0 ? "" : ", ") << "{\"clause\": " << top[i].node + 1 << ", \"kind\": \"" << (clause->is_learned() ? "learned" : "axiom")
+			<< "\", \"width\": " << clause->width() << ", \"copies\": \"" << top[i].copies << "\", \"references\": " << top[i].references << "}";
+	}
+	out << "]}}" << std::endl;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "proof_dag.hpp"
+
+// How often a shared clause (learned clause or axiom) of the used proof is
+// used. copies is the number of times it appears in the tree-like expansion
+// of the proof, i.e. the number of paths from the root to it, and references
+// the number of resolution steps that use it directly
+struct clause_reuse
+{
+	long long node;
+	long double copies;
+	long long references;
+};
+
+// ProofReuse computes copies and references for every used node of a
+// ProofDag with a single pass in reverse topological order. The size of the
+// tree-like expansion (the tree_copy_cost statistic) is the sum of all copies
+class ProofReuse
+{
+public:
+	ProofReuse(const ProofDag& dag);
+
+	long double tree_size() const;
+	long double copies(long long node) const;
+	long long references(long long node) const;
+
+	// The k learned clauses and axioms with the most copies, most copied first
+	std::vector<clause_reuse> most_copied(size_t k) const;
+
+	// Writes log2 histograms of copies and references for learned clauses and
+	// axioms, and the top_k most copied, as a single JSON object. Clauses are
+	// identified by their 1-based position in the DAG, as in exported proofs
+	void write_json(std::ostream& out, size_t top_k) const;
+
+private:
+	const ProofDag& dag;
+	std::vector<long double> node_copies;
+	std::vector<long long> node_references;
+	long double total;
+};
@@ -1,19 +1,62 @@
 #include "resolution_graph.hpp"
+#include "profiler.hpp"
+#include "histograms.hpp"
+#include "windows.hpp"
 
-ResolutionGraph::ResolutionGraph(const SolverShadow& _solver, int conflict_ref, bool _build_graph) : solver(_solver), build_graph(_build_graph)
+ResolutionGraph::ResolutionGraph(const SolverShadowBase& _solver, int conflict_ref, bool _build_graph, DotWriter* _dot, refutation_marks* _marks, analysis_passes _passes) :
+	solver(_solver), build_graph(_build_graph), passes(required_passes(_passes)), dot(_dot), marks(_marks)
 {
 	node_index = 0;
 	s.regularity_violations_total = 0;
+	s.passes = passes;
+	refutation_number = marks ? ++marks->refutations : 0;
+	if(marks) s.refutation = refutation_number;
+	if(marks) marks->passes &= passes;
 
-	empty_clause = resolve_conflict(conflict_ref);
-	assert(empty_clause->empty());
-	s.copy_cost = empty_clause->copy_cost();
-	build_used_graph();
-	add_unused();
+	{
+		PROFILE_SCOPE(phase_resolve_conflict);
+		empty_clause = resolve_conflict(conflict_ref);
+	}
+	// Before the used traversal marks the learned clauses of this
+	// refutation, which the DAG would otherwise stop at
+	if(passes & pass_proof_dag)
+	{
+		PROFILE_SCOPE(phase_copy_count);
+		used_proof.reset(new ProofDag(empty_clause, marks != nullptr));
+		if(passes & pass_copy_cost) measure_copy_cost();
+		if(passes & pass_clause_space) measure_clause_space();
+		if( ! (passes & pass_export) || refutation_number > 1) used_proof.reset();
+	}
+	{
+		PROFILE_SCOPE(phase_used_traversal);
+		build_used_graph();
+	}
+	if(passes & pass_unused)
+	{
+		PROFILE_SCOPE(phase_unused_traversal);
+		add_unused();
+	}
+
+	graph_bytes = build_graph ? boost_graph_bytes() : 0;
+	memory_add(memory_graph, graph_bytes);
+}
+
+ResolutionGraph::~ResolutionGraph()
+{
+	memory_add(memory_graph, -graph_bytes);
+}
+
+// Estimate, since adjacency_list does not take an allocator: every vertex
+// holds its properties and an out-edge vector, and every edge its target
+long long ResolutionGraph::boost_graph_bytes() const
+{
+	return boost::num_vertices(g) * (sizeof(vertex_info) + sizeof(std::vector<Graph::vertex_descriptor>))
+		+ boost::num_edges(g) * sizeof(Graph::vertex_descriptor);
 }
 
 // Start with the final conflict clause and resolve with the reasons for all variables,
-// in reverse assignment order
+// in reverse assignment order. Decisions have no reason, so with assumptions
+// (incremental solving) the result is the negation of those it depends on
 clause_ref ResolutionGraph::resolve_conflict(int conflict_ref)
 {
 	std::shared_ptr<const Clause> remaining = solver.clause_by_cref(conflict_ref);
@@ -21,36 +64,106 @@ clause_ref ResolutionGraph::resolve_conflict(int conflict_ref)
 	// Resolve conflict down to the empty clause
 	while( ! remaining->empty())
 	{
-		// Find literal with max index
-		Literal last = remaining->literals().front();
+		// Find literal with max index that is not a decision
+		int last_index = -1;
 		for(Literal& l : remaining->literals())
 		{
-			if(solver.index[l.variable()] > solver.index[last.variable()]) last = l;
+			int i = solver.index[l.variable()];
+			if(i != -1 && std::get<3>(solver.trail[i]) != nullptr) last_index = std::max(last_index, i);
 		}
+		if(last_index == -1) break;
 
-		int i = solver.index[last.variable()];
-		trail_item t = solver.trail[i];
-		int reason_index = std::get<2>(t);
-		clause_ref reason = std::get<3>(t);
+		clause_ref reason = std::get<3>(solver.trail[last_index]);
 		remaining = Clause::resolve(remaining, reason);
 	}
 
 	return remaining;
 }
 
+// Size of the tree-like expansion of the refutation and its depth (the
+// longest path from the root to an axiom), with a single pass over the proof
+// in topological order. Learned clauses used by an earlier refutation are
+// leaves that count with the size and depth of their own derivation
+void ResolutionGraph::measure_copy_cost()
+{
+	const ProofDag& dag = *used_proof;
+	std::vector<long double> sizes(dag.size());
+	std::vector<long long> depths(dag.size());
+
+	for(size_t i=0; i < dag.size(); i++)
+	{
+		const dag_node& node = dag.nodes()[i];
+		if(node.first != -1)
+		{
+			sizes[i] = 1 + sizes[node.first] + sizes[node.second];
+			depths[i] = 1 + std::max(depths[node.first], depths[node.second]);
+		}
+		else if(node.clause->is_learned())
+		{
+			const learned_measures& earlier = marks->measures.at(node.clause);
+			sizes[i] = earlier.tree_size;
+			depths[i] = earlier.depth;
+		}
+		else
+		{
+			sizes[i] = 1;
+			depths[i] = 0;
+		}
+
+		if(marks && node.clause->is_learned()) marks->measures[node.clause] = learned_measures{sizes[i], depths[i]};
+	}
+
+	s.copy_cost = sizes[dag.root()];
+	s.depth = depths[dag.root()];
+}
+
+// The clause space is the most clauses that are in memory at once when the
+// proof is derived in topological order and every clause is dropped after its
+// last use. Going from the root to the leaves, the clauses in memory right
+// after deriving a node are the node itself and those that a later node still
+// needs but that were not derived yet, so a single reverse pass finds it
+//
+// Unlike the tree size and depth, the clause space of a proof does not follow
+// from that of its parts. From the second refutation on, it only covers the
+// part of the proof that is new (with the learned clauses of earlier
+// refutations as leaves), which keeps all refutations together linear in the
+// size of the clause DAG
+void ResolutionGraph::measure_clause_space()
+{
+	const ProofDag& dag = *used_proof;
+	std::vector<bool> needed(dag.size(), false);
+	long long waiting = 0;
+	for(long long i=dag.root(); i >= 0; i--)
+	{
+		const dag_node& node = dag.nodes()[i];
+		if(needed[i]) waiting--;
+
+		if(node.first != -1)
+		{
+			for(long long parent : {node.first, node.second})
+			{
+				if(needed[parent]) continue;
+				needed[parent] = true;
+				waiting++;
+			}
+		}
+		s.clause_space = std::max(s.clause_space, waiting + 1);
+	}
+}
+
 void ResolutionGraph::build_used_graph()
 {
 	// Start from the empty clause and do a BFS to build complete graph
 	// of all used nodes
-	typedef std::pair<clause_ref, int> queue_item;
-	std::vector<bool> regularity_violation_variables(solver.num_vars(), false);
+	std::vector<bool> regularity_violation_variables((passes & pass_regularity) ? solver.num_vars() : 0, false);
 	std::queue<queue_item> queue;
 	queue.push(queue_item(empty_clause, next_index()));
 
-	if(empty_clause->violated_regularity())
+	if((passes & pass_regularity) && empty_clause->violated_regularity())
 	{
 		s.regularity_violations_total += 1;
 		regularity_violation_variables[empty_clause->violated_regularity_variable()] = true;
+		if(histograms_active) histogram_violation(empty_clause->violated_regularity_variable());
 	}
 
 	while( ! queue.empty())
@@ -59,12 +172,21 @@ void ResolutionGraph::build_used_graph()
 		clause_ref clause = item.first;
 		int index = item.second;
 		if(build_graph) g[index].clause = clause;
+		if(dot) dot->node(index, *clause, true);
+
+		// Learned clauses that an earlier refutation used were counted there,
+		// and are only leaves here
+		if(used_earlier(*clause))
+		{
+			s.earlier_used_learned++;
+			continue;
+		}
 
 		if(clause->is_axiom()) s.used_axioms++;
 		else if(clause->is_learned()) s.used_learned++;
 		else s.used_intermediate++;
 
-		s.width = std::max(s.width, (long long) clause->width());
+		if(passes & pass_width) s.width = std::max(s.width, (long long) clause->width());
 
 		// Add all unvisited children to the graph
 		// and queue up all learned clauses for further
@@ -73,44 +195,13 @@ void ResolutionGraph::build_used_graph()
 		{
 			std::pair<clause_ref, clause_ref> parents = clause->resolved_from();
 
-			int sub_index_1, sub_index_2;
-			if(parents.first->is_learned() == false || learned_clause_index.count(parents.first.get()) == 0)
-			{
-				sub_index_1 = next_index();
-				queue.push(queue_item(parents.first, sub_index_1));
-				if(parents.first->is_learned()) learned_clause_index[parents.first.get()] = sub_index_1;
-				if(parents.first->violated_regularity())
-				{
-					s.regularity_violations_total += 1;
-					regularity_violation_variables[parents.first->violated_regularity_variable()] = true;
-				}
-			}
-			else
-			{
-				sub_index_1 = learned_clause_index.at(parents.first.get());
-				s.tree_edge_violations++;
-				violating_learned.insert(parents.first.get());
-			}
+			int sub_index_1 = add_used_parent(parents.first, queue, regularity_violation_variables);
 			if(build_graph) boost::add_edge(index, sub_index_1, g);
+			if(dot) dot->edge(index, sub_index_1, *clause, true);
 
-			if(parents.second->is_learned() == false || learned_clause_index.count(parents.second.get()) == 0)
-			{
-				sub_index_2 = next_index();
-				queue.push(queue_item(parents.second, sub_index_2));
-				if(parents.second->is_learned()) learned_clause_index[parents.second.get()] = sub_index_2;
-				if(parents.second->violated_regularity())
-				{
-					s.regularity_violations_total += 1;
-					regularity_violation_variables[parents.second->violated_regularity_variable()] = true;
-				}
-			}
-			else
-			{
-				sub_index_2 = learned_clause_index.at(parents.second.get());
-				s.tree_edge_violations++;
-				violating_learned.insert(parents.second.get());
-			}
+			int sub_index_2 = add_used_parent(parents.second, queue, regularity_violation_variables);
 			if(build_graph) boost::add_edge(index, sub_index_2, g);
+			if(dot) dot->edge(index, sub_index_2, *clause, true);
 		}
 	}
 
@@ -123,9 +214,39 @@ void ResolutionGraph::build_used_graph()
 	}
 }
 
+int ResolutionGraph::add_used_parent(const clause_ref& parent, std::queue<queue_item>& queue, std::vector<bool>& regularity_violation_variables)
+{
+	if(parent->is_learned() && learned_clause_index.count(parent.get()) > 0)
+	{
+		if(passes & pass_tree_violations)
+		{
+			s.tree_edge_violations++;
+			violating_learned.insert(parent.get());
+			if(window_width > 0) window_violation(parent->learned_ordinal());
+		}
+		return learned_clause_index.at(parent.get());
+	}
+
+	int index = next_index();
+	if(parent->is_learned()) learned_clause_index[parent.get()] = index;
+
+	queue.push(queue_item(parent, index));
+	if(used_earlier(*parent)) return index;
+
+	if(marks && parent->is_learned()) parent->mark_refutation(refutation_number);
+	if(window_width > 0 && parent->is_learned()) window_used(parent->learned_ordinal(), parent->width());
+	if((passes & pass_regularity) && parent->violated_regularity())
+	{
+		s.regularity_violations_total += 1;
+		regularity_violation_variables[parent->violated_regularity_variable()] = true;
+		if(histograms_active) histogram_violation(parent->violated_regularity_variable());
+	}
+
+	return index;
+}
+
 void ResolutionGraph::add_unused()
 {
-	typedef std::pair<clause_ref, int> queue_item;
 	std::queue<queue_item> queue;
 
 	// Next, add all unvisited learned clauses to the queue and traverse
@@ -135,16 +256,17 @@ void ResolutionGraph::add_unused()
 		for(int i=solver.first_learned_index; i < solver.clauses.size(); i++)
 		{
 			clause_ref c = solver.clauses[i];
-			if(c == nullptr) continue;
+			// Input clauses of later incremental calls follow learned ones
+			if(c == nullptr || ! c->is_learned()) continue;
 
-			assert(c->is_learned());
-			bool unexplained = learned_clause_index.count(c.get()) == 0;
+			bool unexplained = learned_clause_index.count(c.get()) == 0 && ! classified_earlier(*c);
 
 			if(unexplained)
 			{
 				int index = next_index();
 				queue.push(queue_item(c, index));
 				learned_clause_index[c.get()] = index;
+				if(marks) c->mark_refutation(-refutation_number);
 			}
 
 		}
@@ -160,6 +282,7 @@ void ResolutionGraph::add_unused()
 				g[index].clause = clause;
 				g[index].used = false;
 			}
+			if(dot) dot->node(index, *clause, false);
 
 			if(clause->is_axiom()) s.unused_axioms++;
 			else if(clause->is_learned()) s.unused_learned++;
@@ -176,14 +299,20 @@ void ResolutionGraph::add_unused()
 			{
 				sub_index_1 = learned_clause_index[parents.first.get()];
 			}
+			else if(parents.first->is_learned() && classified_earlier(*parents.first))
+			{
+				sub_index_1 = -1;
+			}
 			else
 			{
 				sub_index_1 = next_index();
 				queue.push(queue_item(parents.first, sub_index_1));
 				if(parents.first->is_learned()) learned_clause_index[parents.first.get()] = sub_index_1;
+				if(marks && parents.first->is_learned()) parents.first->mark_refutation(-refutation_number);
 			}
 			
-			if(build_graph) boost::add_edge(index, sub_index_1, g);
+			if(build_graph && sub_index_1 != -1) boost::add_edge(index, sub_index_1, g);
+			if(dot && sub_index_1 != -1) dot->edge(index, sub_index_1, *clause, false);
 
 			already_used = parents.second->is_learned() && learned_clause_index.count(parents.second.get()) > 0;
 
@@ -191,14 +320,20 @@ void ResolutionGraph::add_unused()
 			{
 				sub_index_2 = learned_clause_index[parents.second.get()];
 			}
+			else if(parents.second->is_learned() && classified_earlier(*parents.second))
+			{
+				sub_index_2 = -1;
+			}
 			else
 			{
 				sub_index_2 = next_index();
 				queue.push(queue_item(parents.second, sub_index_2));
 				if(parents.second->is_learned()) learned_clause_index[parents.second.get()] = sub_index_2;
+				if(marks && parents.second->is_learned()) parents.second->mark_refutation(-refutation_number);
 			}
 			
-			if(build_graph) boost::add_edge(index, sub_index_2, g);
+			if(build_graph && sub_index_2 != -1) boost::add_edge(index, sub_index_2, g);
+			if(dot && sub_index_2 != -1) dot->edge(index, sub_index_2, *clause, false);
 		}
 	}
 }
@@ -239,6 +374,31 @@ statistics ResolutionGraph::vertex_statistics() const
 	return s;
 }
 
+// A learned clause an earlier refutation used, which is a leaf of this one
+bool ResolutionGraph::used_earlier(const Clause& clause) const
+{
+	return marks && clause.is_learned() && clause.refutation_mark() > 0 && clause.refutation_mark() != refutation_number;
+}
+
+// Whether an earlier refutation already used the clause or reached it from
+// the unused learned clauses, in which case its derivation was counted there.
+// Only asked for clauses this refutation did not reach yet
+bool ResolutionGraph::classified_earlier(const Clause& clause) const
+{
+	return marks && clause.refutation_mark() != 0;
+}
+
+clause_ref ResolutionGraph::refutation() const
+{
+	return empty_clause;
+}
+
+std::unique_ptr<ProofDag> ResolutionGraph::take_used_proof()
+{
+	if(used_proof == nullptr) used_proof.reset(new ProofDag(empty_clause));
+	return std::move(used_proof);
+}
+
 int ResolutionGraph::next_index()
 {
 	if(build_graph)
@@ -266,3 +426,38 @@ void ResolutionGraph::remove_unused()
 		}
 	}
 }
+
+namespace
+{
+	void jsonPrinFloat(std::ostream& s, long double value) {
+		s << "\"" << value << "\"";
+	}
+}
+
+void write_statistics(std::ostream& out, const statistics& s)
+{
+	bool unused = s.passes & pass_unused;
+
+	out << "{";
+	if(s.refutation > 1) out << "\"refutation\": " << s.refutation << ", \"earlier_used_learned\": " << s.earlier_used_learned << ",";
+	out << "\"used_axioms\": " << s.used_axioms;
+	if(unused) out << ", \"unused_axioms\": " << s.unused_axioms;
+	out << ",\"used_intermediate\": " << s.used_intermediate;
+	if(unused) out << ", \"unused_intermediate\": " << s.unused_intermediate;
+	out << ",\"used_learned\": " << s.used_learned;
+	if(unused) out << ", \"unused_learned\": " << s.unused_learned;
+
+	if(s.passes & pass_tree_violations) out << ",\"tree_edge_violations\": " << s.tree_edge_violations << ", \"tree_vertex_violations\": " << s.tree_vertex_violations;
+	if(s.passes & pass_copy_cost)
+	{
+		out << ",\"tree_copy_cost\": ";
+		jsonPrinFloat(out, s.copy_cost);
+		out << ", \"depth\": " << s.depth;
+	}
+	if(s.passes & pass_clause_space) out << ", \"" << (s.refutation > 1 ? "new_clause_space" : "clause_space") << "\": " << s.clause_space;
+
+	if(s.passes & pass_regularity) out << ", \"regularity_violations_total\": " << s.regularity_violations_total << ", \"regularity_violation_variables\": " << s.regularity_violation_variables;
+
+	if(s.passes & pass_width) out << ",\"max_width\": " << s.width;
+	out << "}" << std::endl;
+}
@@ -1,34 +1,103 @@
 #pragma once
 #include "solver_shadow.hpp"
 #include "resolution_graph_extras.hpp"
+#include "dot_writer.hpp"
+#include "proof_dag.hpp"
 #include <iostream>
+#include <memory>
+
+// Classification shared by the refutations of one trace. Incremental solving
+// reports a final conflict (C) per unsatisfiable call, and the traversals of
+// every refutation stop at the learned clauses an earlier one classified
+// (marked in the clauses themselves, see Clause::refutation_mark), so that all
+// refutations together visit each part of the clause DAG about once
+struct learned_measures
+{
+	long double tree_size;
+	long long depth;
+};
+
+struct refutation_marks
+{
+	int refutations = 0;
+	// Size of the tree-like expansion and depth of every learned clause a
+	// refutation used, for the tree_copy_cost and depth of later ones. Only
+	// read for clauses marked as used, so entries of clauses freed since are
+	// never read
+	counted_map<const Clause*, learned_measures, memory_graph> measures;
+	// Passes the replay so far was made with. Later refutations can only count
+	// unused clauses and tree copies on top of earlier ones that did too, and
+	// removed clauses are reclaimed without the unused pass
+	analysis_passes passes = all_passes;
+};
 
 // ResolutionGraph takes the information from the solver shadow and
 // calculates statistics on the resolution graph (and, given the build_graph
 // parameter, builds a graph using the Boost library, which can be printed as
 // graphviz)
+// Given a DotWriter, the graph is instead streamed out as GraphViz during the
+// traversal, without building the Boost graph
+//
+// Given refutation_marks, the graph only covers what earlier refutations did
+// not classify yet (learned clauses they used are leaves)
+//
+// Only the given passes (and those they depend on, see analysis_passes.hpp)
+// run, and only their statistics are printed
 class ResolutionGraph
 {
 public:
-	ResolutionGraph(const SolverShadow& _rg, int conflict_ref, bool build_graph);
+	ResolutionGraph(const SolverShadowBase& _rg, int conflict_ref, bool build_graph, DotWriter* _dot = nullptr, refutation_marks* _marks = nullptr, analysis_passes _passes = all_passes);
+	~ResolutionGraph();
+	// Not copyable, since the graph's memory is accounted for once
+	ResolutionGraph(const ResolutionGraph&) = delete;
 	void print_graphviz(std::ostream& stream) const;
 	statistics vertex_statistics() const;
 	void remove_unused();
+	// The clause the final conflict was resolved to: empty, unless the
+	// conflict depends on decisions (the assumptions of an incremental call),
+	// whose negations it then consists of
+	clause_ref refutation() const;
+	// The used part of the refutation as a ProofDag. With pass_export, the
+	// one the copy cost and clause space were measured on is handed over
+	// instead of building it again, unless it stops at the learned clauses of
+	// earlier refutations
+	std::unique_ptr<ProofDag> take_used_proof();
 private:
+	typedef std::pair<clause_ref, int> queue_item;
+
 	clause_ref resolve_conflict(int conflict_ref);
+	void measure_copy_cost();
+	void measure_clause_space();
 	void build_used_graph();
+	// Returns the index of a parent of a used clause, queueing it unless it
+	// is a learned clause that was already reached
+	int add_used_parent(const clause_ref& parent, std::queue<queue_item>& queue, std::vector<bool>& regularity_violation_variables);
 	void add_unused();
+	bool used_earlier(const Clause& clause) const;
+	bool classified_earlier(const Clause& clause) const;
 	int next_index();
+	long long boost_graph_bytes() const;
 
-	const SolverShadow& solver;
+	const SolverShadowBase& solver;
 	Graph g;
-	std::map<const Clause*, int> learned_clause_index;
+	counted_map<const Clause*, int, memory_graph> learned_clause_index;
 	statistics s;
 	// Keep track of all learned clauses that have been used more than once
-	std::set<const Clause*> violating_learned;
+	counted_set<const Clause*, memory_graph> violating_learned;
+	long long graph_bytes;
 	const bool build_graph;
+	const analysis_passes passes;
+	// Flat copy of the used proof, shared by the passes that need one
+	std::unique_ptr<ProofDag> used_proof;
+	DotWriter* dot;
 	clause_ref empty_clause;
+	refutation_marks* marks;
+	// Number of this refutation, 0 without marks
+	int refutation_number;
 
 	// Used when graph is not built
 	int node_index;
 };
+
+// Writes the statistics as the single JSON line printed by ResolutionGraph
+void write_statistics(std::ostream& out, const statistics& s);
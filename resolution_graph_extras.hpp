@@ -3,6 +3,7 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graphviz.hpp>
 #include "solver_shadow.hpp"
+#include "analysis_passes.hpp"
 
 // State that is needed by vertex (i.e. by clause)
 struct vertex_info
@@ -19,6 +20,16 @@ struct statistics
 	    tree_edge_violations = 0, tree_vertex_violations = 0,
 	    regularity_violation_variables = 0, width = 0, regularity_violations_total = 0;
 	long double copy_cost = 0;
+	// Longest path from the root to an axiom, and the most clauses in memory
+	// at once when the used proof is derived in topological order
+	long long depth = 0, clause_space = 0;
+	// With several refutations (incremental solving), the counts above only
+	// cover what this refutation classified first, and earlier_used_learned
+	// counts the learned clauses it shares with an earlier refutation
+	int refutation = 1;
+	long long earlier_used_learned = 0;
+	// The statistics of other passes were not computed, and are not printed
+	analysis_passes passes = all_passes;
 };
 
 typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, vertex_info> Graph;
@@ -0,0 +1,368 @@
+#include "snapshot.hpp"
+#include "buffered_writer.hpp"
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	const char magic[8] = {'R', 'G', 'S', 'N', 'A', 'P', '5', '\n'};
+
+	void write_varint(BufferedWriter& writer, unsigned long long value)
+	{
+		char bytes[10];
+		int length = 0;
+
+		while(value >= 0x80)
+		{
+			bytes[length++] = (char) ((value & 0x7f) | 0x80);
+			value >>= 7;
+		}
+		bytes[length++] = (char) value;
+
+		writer.write(bytes, length);
+	}
+
+	void write_string(BufferedWriter& writer, const std::string& s)
+	{
+		write_varint(writer, s.size());
+		writer << s;
+	}
+
+	// Refutation marks are negative for clauses only the unused traversal
+	// reached
+	unsigned long long zigzag(long long value)
+	{
+		return value < 0 ? 2 * (unsigned long long) -value - 1 : 2 * (unsigned long long) value;
+	}
+
+	long long unzigzag(unsigned long long code)
+	{
+		return code & 1 ? -(long long) ((code + 1) / 2) : (long long) (code / 2);
+	}
+
+	unsigned long long literal_code(const Literal& l)
+	{
+		return 2 * (unsigned long long) l.variable() + (l.negated() ? 1 : 0);
+	}
+
+	// Reads from an in-memory copy of the snapshot. Once anything is out of
+	// bounds, ok is cleared and every further read returns 0
+	class SnapshotReader
+	{
+	public:
+		SnapshotReader(const std::string& _data) : data(_data), position(0), ok(true)
+		{
+		}
+
+		unsigned long long varint()
+		{
+			unsigned long long value = 0;
+			for(int shift=0; ok && shift < 64; shift += 7)
+			{
+				if(position >= data.size()) break;
+				unsigned char byte = data[position++];
+				value |= (unsigned long long) (byte & 0x7f) << shift;
+				if((byte & 0x80) == 0) return value;
+			}
+
+			ok = false;
+			return 0;
+		}
+
+		// A number of entries, each taking at least min_bytes, so that a
+		// corrupt count is rejected before anything is allocated for it
+		size_t count(size_t min_bytes)
+		{
+			unsigned long long value = varint();
+			if( ! ok || value > (data.size() - position) / min_bytes)
+			{
+				ok = false;
+				return 0;
+			}
+			return value;
+		}
+
+		std::string string()
+		{
+			return bytes(varint());
+		}
+
+		std::string bytes(size_t length)
+		{
+			if( ! ok || data.size() - position < length)
+			{
+				ok = false;
+				return "";
+			}
+
+			position += length;
+			return data.substr(position - length, length);
+		}
+
+		const std::string& data;
+		size_t position;
+		bool ok;
+	};
+
+	enum node_flags
+	{
+		node_resolvent = 1,
+		node_learned = 2
+	};
+
+	// Every clause reachable from the solver state, parents before children
+	std::vector<const Clause*> topological_order(const std::vector<const Clause*>& roots, std::unordered_map<const Clause*, long long>& ids)
+	{
+		std::vector<const Clause*> order;
+		typedef std::pair<const Clause*, bool> frame;
+		std::vector<frame> stack;
+
+		for(const Clause* root : roots)
+		{
+			if(root == nullptr || ids.count(root) > 0) continue;
+			stack.push_back(frame(root, false));
+
+			while( ! stack.empty())
+			{
+				frame f = stack.back();stack.pop_back();
+				const Clause* clause = f.first;
+				if(ids.count(clause) > 0) continue;
+
+				bool ready = ! clause->is_resolvent();
+				if( ! ready && f.second) ready = true;
+
+				if(ready)
+				{
+					ids[clause] = order.size();
+					order.push_back(clause);
+					continue;
+				}
+
+				std::pair<clause_ref, clause_ref> parents = clause->resolved_from();
+				stack.push_back(frame(clause, true));
+				if(ids.count(parents.second.get()) == 0) stack.push_back(frame(parents.second.get(), false));
+				if(ids.count(parents.first.get()) == 0) stack.push_back(frame(parents.first.get(), false));
+			}
+		}
+
+		return order;
+	}
+}
+
+void write_snapshot(std::ostream& out, const SolverShadowBase& solver, const refutation_marks& marks, const snapshot_header& header)
+{
+	BufferedWriter writer(out);
+	writer.write(magic, sizeof(magic));
+
+	write_varint(writer, header.mode);
+	write_varint(writer, header.offset);
+	write_varint(writer, header.lines);
+	write_varint(writer, header.events);
+	write_varint(writer, header.learned);
+	write_varint(writer, header.restarts);
+	write_varint(writer, header.relocations);
+	write_varint(writer, marks.refutations);
+	write_varint(writer, marks.passes);
+
+	std::vector<const Clause*> roots;
+	for(const clause_ref& c : solver.clauses) roots.push_back(c.get());
+	for(const trail_item& item : solver.trail) roots.push_back(std::get<3>(item).get());
+
+	std::unordered_map<const Clause*, long long> ids;
+	std::vector<const Clause*> order = topological_order(roots, ids);
+
+	// Ids are written off by one, so that 0 stands for no clause
+	auto id = [&ids](const clause_ref& c) -> unsigned long long
+	{
+		return c == nullptr ? 0 : ids.at(c.get()) + 1;
+	};
+
+	write_varint(writer, order.size());
+	for(const Clause* clause : order)
+	{
+		write_varint(writer, (clause->is_resolvent() ? node_resolvent : 0) | (clause->is_learned() ? node_learned : 0));
+		write_varint(writer, zigzag(clause->refutation_mark()));
+
+		if(clause->is_resolvent())
+		{
+			std::pair<clause_ref, clause_ref> parents = clause->resolved_from();
+			write_varint(writer, id(parents.first));
+			write_varint(writer, id(parents.second));
+			if(clause->is_learned()) write_varint(writer, clause->learned_ordinal());
+		}
+		else
+		{
+			std::vector<Literal> literals = clause->literals();
+			write_varint(writer, literals.size());
+			for(const Literal& l : literals) write_varint(writer, literal_code(l));
+		}
+
+		// Learned clauses some refutation used carry their tree size, in the
+		// representation of this machine, and their depth, as long as every
+		// refutation counted tree copies
+		if((marks.passes & pass_copy_cost) && clause->is_learned() && clause->refutation_mark() > 0)
+		{
+			const learned_measures& measures = marks.measures.at(clause);
+			writer.write(reinterpret_cast<const char*>(&measures.tree_size), sizeof(measures.tree_size));
+			write_varint(writer, measures.depth);
+		}
+	}
+
+	write_varint(writer, solver.clauses.size());
+	for(const clause_ref& c : solver.clauses) write_varint(writer, id(c));
+
+	write_varint(writer, solver.cref_map.size());
+	for(const std::pair<const int, int>& entry : solver.cref_map)
+	{
+		write_varint(writer, entry.first);
+		write_varint(writer, entry.second);
+	}
+
+	write_varint(writer, solver.unit_map.size());
+	for(const std::pair<const int, int>& entry : solver.unit_map)
+	{
+		write_varint(writer, entry.first);
+		write_varint(writer, entry.second);
+	}
+
+	// Unassigned variables have index -1
+	write_varint(writer, solver.index.size());
+	for(int i : solver.index) write_varint(writer, i + 1);
+
+	write_varint(writer, solver.decision_level);
+	write_varint(writer, solver.trail.size());
+	for(const trail_item& item : solver.trail)
+	{
+		write_varint(writer, std::get<0>(item));
+		write_varint(writer, literal_code(std::get<1>(item)));
+		write_varint(writer, std::get<2>(item) + 1);
+		write_varint(writer, id(std::get<3>(item)));
+	}
+
+	write_varint(writer, solver.first_learned_index + 1);
+
+	write_varint(writer, solver.clauses_with_ignored.size());
+	for(const std::pair<const std::string, int>& entry : solver.clauses_with_ignored)
+	{
+		write_string(writer, entry.first);
+		write_varint(writer, entry.second);
+	}
+
+	writer.write(magic, sizeof(magic));
+}
+
+bool read_snapshot(std::istream& in, SolverShadowBase& solver, refutation_marks& marks, snapshot_header& header)
+{
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if(data.size() < 2 * sizeof(magic) || std::memcmp(data.data(), magic, sizeof(magic)) != 0) return false;
+	if(std::memcmp(data.data() + data.size() - sizeof(magic), magic, sizeof(magic)) != 0) return false;
+
+	SnapshotReader r(data);
+	r.position = sizeof(magic);
+
+	header.mode = r.varint();
+	header.offset = r.varint();
+	header.lines = r.varint();
+	header.events = r.varint();
+	header.learned = r.varint();
+	header.restarts = r.varint();
+	header.relocations = r.varint();
+	marks.refutations = r.varint();
+	marks.passes = r.varint();
+
+	// Nodes take at least their flags and mark
+	std::vector<clause_ref> nodes(r.count(2));
+	auto node = [&](unsigned long long id) -> clause_ref
+	{
+		if(id == 0) return nullptr;
+		if(id > nodes.size() || nodes[id - 1] == nullptr)
+		{
+			r.ok = false;
+			return nullptr;
+		}
+		return nodes[id - 1];
+	};
+
+	for(size_t i=0; r.ok && i < nodes.size(); i++)
+	{
+		unsigned long long flags = r.varint();
+		int mark = unzigzag(r.varint());
+
+		if(flags & node_resolvent)
+		{
+			clause_ref first = node(r.varint());
+			clause_ref second = node(r.varint());
+			if(first == nullptr || second == nullptr) return false;
+
+			clause_ref resolvent = Clause::resolve(first, second);
+			if(flags & node_learned) resolvent = std::make_shared<const Clause>(Clause(*resolvent, true, r.varint()));
+			nodes[i] = resolvent;
+		}
+		else
+		{
+			std::vector<Literal> literals(r.count(1), Literal(0, false));
+			for(Literal& l : literals)
+			{
+				unsigned long long code = r.varint();
+				l = Literal(code >> 1, code & 1);
+			}
+			nodes[i] = std::make_shared<const Clause>(Clause(literals));
+		}
+
+		nodes[i]->mark_refutation(mark);
+		if((marks.passes & pass_copy_cost) && (flags & node_learned) && mark > 0)
+		{
+			learned_measures measures;
+			std::string bytes = r.bytes(sizeof(measures.tree_size));
+			if( ! r.ok) return false;
+			std::memcpy(&measures.tree_size, bytes.data(), sizeof(measures.tree_size));
+			measures.depth = r.varint();
+			marks.measures[nodes[i].get()] = measures;
+		}
+	}
+
+	solver.clauses.resize(r.count(1));
+	for(clause_ref& c : solver.clauses) c = node(r.varint());
+
+	size_t num_crefs = r.varint();
+	for(size_t i=0; r.ok && i < num_crefs; i++)
+	{
+		int cref = r.varint();
+		solver.cref_map[cref] = r.varint();
+	}
+
+	size_t num_units = r.varint();
+	for(size_t i=0; r.ok && i < num_units; i++)
+	{
+		int variable = r.varint();
+		solver.unit_map[variable] = r.varint();
+	}
+
+	solver.index.resize(r.count(1));
+	for(int& i : solver.index) i = (long long) r.varint() - 1;
+
+	solver.decision_level = r.varint();
+	size_t trail_size = r.varint();
+	for(size_t i=0; r.ok && i < trail_size; i++)
+	{
+		int level = r.varint();
+		unsigned long long code = r.varint();
+		int reason_index = (long long) r.varint() - 1;
+		clause_ref reason = node(r.varint());
+		solver.trail.push_back(std::make_tuple(level, Literal(code >> 1, code & 1), reason_index, reason));
+	}
+
+	solver.first_learned_index = (long long) r.varint() - 1;
+
+	size_t num_ignored = r.varint();
+	for(size_t i=0; r.ok && i < num_ignored; i++)
+	{
+		std::string key = r.string();
+		solver.clauses_with_ignored[key] = r.varint();
+	}
+
+	return r.ok && r.position == data.size() - sizeof(magic);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include "solver_shadow.hpp"
+#include "resolution_graph.hpp"
+
+// Where in the trace a snapshot was taken, and the replay counters at that
+// point, so that a resumed run continues exactly where the snapshot left off
+struct snapshot_header
+{
+	int mode = 0;
+	// Bytes and lines of the trace consumed before the snapshot
+	long long offset = 0;
+	long long lines = 0;
+	long long events = 0;
+	long long learned = 0;
+	long long restarts = 0;
+	long long relocations = 0;
+};
+
+// A snapshot holds the complete state of a solver shadow: the clause DAG
+// (every clause reachable from the clause list and the trail, with sharing
+// preserved), the cref and unit maps, the trail, the variable index, the
+// clauses with ignored literals and the first learned index, as well as the
+// refutation marks of the clauses and the analysis passes they were made
+// with, for traces with several refutations
+//
+// Clauses are written in topological order. Axioms are written with their
+// literals, resolvents only as the ids of their parents (and the ordinal of
+// learned clauses), and are resolved again when the snapshot is read, which
+// restores every derived field exactly. Everything is stored as LEB128 varints
+void write_snapshot(std::ostream& out, const SolverShadowBase& solver, const refutation_marks& marks, const snapshot_header& header);
+
+// Replaces the state of a fresh solver shadow and marks with the snapshot. Returns
+// false if the input is not a complete snapshot
+bool read_snapshot(std::istream& in, SolverShadowBase& solver, refutation_marks& marks, snapshot_header& header);
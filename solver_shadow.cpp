@@ -1,10 +1,12 @@
 #include "solver_shadow.hpp"
+#include "profiler.hpp"
+#include <unordered_set>
 
-SolverShadow::SolverShadow(ignore_mode _mode) : mode(_mode), decision_level(0), first_learned_index(-1)
+SolverShadowBase::SolverShadowBase() : decision_level(0), first_learned_index(-1), reclaim(false), compact(false), clauses_at_compaction(0)
 {
 }
 
-void SolverShadow::add_clause(std::shared_ptr<const Clause> c, int cref)
+void SolverShadowBase::add_clause(std::shared_ptr<const Clause> c, int cref)
 {
 	int clause_index = clauses.size();
 	clauses.push_back(c);
@@ -13,7 +15,7 @@ void SolverShadow::add_clause(std::shared_ptr<const Clause> c, int cref)
 	if(c->is_learned() && first_learned_index == -1) first_learned_index = clause_index;
 }
 
-void SolverShadow::add_unit(std::shared_ptr<const Clause> c)
+void SolverShadowBase::add_unit(std::shared_ptr<const Clause> c)
 {
 	assert(c->unit());
 	add_unit(c, c->first_literal());
@@ -23,14 +25,14 @@ void SolverShadow::add_unit(std::shared_ptr<const Clause> c)
 // learns a unit but we do not. The extra argument specifies the unit
 // the solver claims to have learned, so that we can still store this in the
 // unit map
-void SolverShadow::add_unit(std::shared_ptr<const Clause> c, Literal l)
+void SolverShadowBase::add_unit(std::shared_ptr<const Clause> c, Literal l)
 {
 	int clause_index = clauses.size();
 	clauses.push_back(c);
 	unit_map.insert(std::make_pair(l.variable(), clause_index));
 }
 
-void SolverShadow::decide(const Literal l)
+void SolverShadowBase::decide(const Literal l)
 {
 	decision_level += 1;
 	index[l.variable()] = trail.size();
@@ -39,7 +41,7 @@ void SolverShadow::decide(const Literal l)
 
 // If we propagate a unit without a given reason, the resaon must be the learned
 // unit clause corresponding to this literal
-void SolverShadow::propagate(const Literal& l)
+void SolverShadowBase::propagate(const Literal& l)
 {
 	assert(unit_map.count(l.variable()) > 0);
 	int i = unit_map[l.variable()];
@@ -47,7 +49,8 @@ void SolverShadow::propagate(const Literal& l)
 	trail.push_back(std::make_tuple(decision_level, l, i, clauses[i]));
 }
 
-void SolverShadow::propagate(const Literal& l, int cref)
+template<ignore_mode mode>
+void SolverShadow<mode>::propagate(const Literal& l, int cref)
 {
 	assert(cref_map.count(cref) > 0);
 	int clause_index = cref_map[cref];
@@ -57,17 +60,21 @@ void SolverShadow::propagate(const Literal& l, int cref)
 	// If we are on decision level 0, a unit propagation is essentially
 	// a learned clause
 	// This learned clause is then naturally derived from other units at level 0
-	if(decision_level == 0 && mode != none)
+	// (without ignoring literals, level 0 literals stay in the clauses instead)
+	if constexpr(mode != none)
 	{
-		std::vector<clause_ref> chain = {via};
-		for(Literal literal : via->literals())
+		if(decision_level == 0)
 		{
-			if(literal != l) chain.push_back(unit_clause(literal));
-		}
+			std::vector<clause_ref> chain = {via};
+			for(Literal literal : via->literals())
+			{
+				if(literal != l) chain.push_back(unit_clause(literal));
+			}
 
-		clause_index = clauses.size();
-		std::shared_ptr<const Clause> new_clause = Clause::resolve(chain);
-		add_unit(std::make_shared<Clause>(Clause(*new_clause, true)), l);
+			clause_index = clauses.size();
+			std::shared_ptr<const Clause> new_clause = Clause::resolve(chain);
+			add_unit(std::make_shared<Clause>(Clause(*new_clause, true, 0)), l);
+		}
 	}
 
 	index[l.variable()] = trail.size();
@@ -76,71 +83,81 @@ void SolverShadow::propagate(const Literal& l, int cref)
 
 // Start with the clause with the given cref and skip the given literals
 // (which have to be propagated at level 0)
-clause_ref SolverShadow::skip(int cref, std::vector<Literal>& literals)
+template<ignore_mode mode>
+clause_ref SolverShadow<mode>::skip(int cref, std::vector<Literal>& literals)
 {
+	PROFILE_SCOPE(phase_skip);
 	int clause_index = cref_map.at(cref);
 	clause_ref clause = clauses[clause_index];
-	if(mode == none) return clause;
-
-	// Skip in trail order so that if we learn a new clause with skipped literals,
-	// we repeat ourselves as little as possible
-	std::sort(literals.begin(), literals.end(), [&](const Literal & a, const Literal & b) -> bool
-		{ 
-			return index[a.variable()] < index[b.variable()]; 
-		}
-	);
 
-	if(mode == resolve_unit)
+	// Without ignoring, skipped literals are left in the clause and are
+	// resolved away during final conflict resolution instead
+	if constexpr(mode == none)
 	{
-		std::vector<clause_ref> units;
-		units.push_back(clause);
-		for(Literal l : literals)
-		{
-			assert(unit_map.count(l.variable()) > 0);
-			int i = unit_map.at(l.variable());
-			clause_ref unit = clauses[i];
-			assert(unit != nullptr);
-			units.push_back(unit);
-		}
-		clause_ref result = Clause::resolve(units);
-		return result;
+		return clause;
 	}
 	else
 	{
-		// We learn clauses without the skipped literals
-		// The "key" here should essentially be {clause index, skipped literals},
-		// where the parent of {x, [1,2,3]} is {x, [1,2]}
-		int i = clause_index;
-		int first_literal_index = 0;
-		std::string key = std::to_string(i) + "_without";
-
-		while(first_literal_index < literals.size())
-		{
-			Literal l = literals[first_literal_index];
-			key += "_" + std::to_string(l.variable());
-			first_literal_index += 1;
+		// Skip in trail order so that if we learn a new clause with skipped literals,
+		// we repeat ourselves as little as possible
+		std::sort(literals.begin(), literals.end(), [&](const Literal & a, const Literal & b) -> bool
+			{ 
+				return index[a.variable()] < index[b.variable()]; 
+			}
+		);
 
-			if(clauses_with_ignored.count(key) > 0)
+		if constexpr(mode == resolve_unit)
+		{
+			std::vector<clause_ref> units;
+			units.push_back(clause);
+			for(Literal l : literals)
 			{
-				i = clauses_with_ignored.at(key);
+				assert(unit_map.count(l.variable()) > 0);
+				int i = unit_map.at(l.variable());
+				clause_ref unit = clauses[i];
+				assert(unit != nullptr);
+				units.push_back(unit);
 			}
-			else
+			clause_ref result = Clause::resolve(units);
+			return result;
+		}
+		else
+		{
+			// We learn clauses without the skipped literals
+			// The "key" here should essentially be {clause index, skipped literals},
+			// where the parent of {x, [1,2,3]} is {x, [1,2]}
+			int i = clause_index;
+			int first_literal_index = 0;
+			std::string key = std::to_string(i) + "_without";
+
+			while(first_literal_index < literals.size())
 			{
-				int unit_index = unit_map.at(l.variable());
-				clause_ref with_ignored = Clause::resolve(clauses[i], clauses[unit_index]);
-				with_ignored = std::make_shared<const Clause>(Clause(*with_ignored, true));
-				int new_index = clauses.size();
-				clauses.push_back(with_ignored);
-				clauses_with_ignored[key] = new_index;
-				i = new_index;
+				Literal l = literals[first_literal_index];
+				key += "_" + std::to_string(l.variable());
+				first_literal_index += 1;
+
+				if(clauses_with_ignored.count(key) > 0)
+				{
+					i = clauses_with_ignored.at(key);
+				}
+				else
+				{
+					int unit_index = unit_map.at(l.variable());
+					clause_ref with_ignored = Clause::resolve(clauses[i], clauses[unit_index]);
+					with_ignored = std::make_shared<const Clause>(Clause(*with_ignored, true, 0));
+					int new_index = clauses.size();
+					clauses.push_back(with_ignored);
+					clauses_with_ignored[key] = new_index;
+					i = new_index;
+				}
 			}
-		}
 
-		return clauses[i];
+			return clauses[i];
+		}
 	}
 }
 
-void SolverShadow::backtrack(int to_level)
+void SolverShadowBase::backtrack(int to_level)
 {
 	while( ! trail.empty())
 	{
@@ -162,7 +179,7 @@ void SolverShadow::backtrack(int to_level)
 	decision_level = to_level;
 }
 
-void SolverShadow::num_vars(int num_vars)
+void SolverShadowBase::num_vars(int num_vars)
 {
 	while(index.size() < num_vars)
 	{
@@ -170,17 +187,52 @@ void SolverShadow::num_vars(int num_vars)
 	}
 }
 
-int SolverShadow::num_vars() const
+int SolverShadowBase::num_vars() const
 {
 	return index.size();
 }
 
-void SolverShadow::restart()
+int SolverShadowBase::num_live_clauses() const
+{
+	return cref_map.size();
+}
+
+int SolverShadowBase::trail_size() const
+{
+	return trail.size();
+}
+
+bool SolverShadowBase::decided(const Literal& l) const
+{
+	int i = index[l.variable()];
+	return i != -1 && std::get<1>(trail[i]) == l && std::get<3>(trail[i]) == nullptr;
+}
+
+void SolverShadowBase::restart()
 {
 	backtrack(0);
+
+	// A sweep visits every clause, so sweeps wait until the clause list has
+	// grown by an eighth since the previous one
+	if(compact && clauses.size() >= clauses_at_compaction + clauses_at_compaction / 8) compact_cold_clauses();
 }
 
-std::shared_ptr<const Clause> SolverShadow::clause_by_cref(int cref) const
+void SolverShadowBase::compact_cold_clauses()
+{
+	std::unordered_set<const Clause*> reasons;
+	for(const trail_item& item : trail)
+	{
+		if(std::get<3>(item) != nullptr) reasons.insert(std::get<3>(item).get());
+	}
+
+	for(const clause_ref& c : clauses)
+	{
+		if(c != nullptr && reasons.count(c.get()) == 0) c->compact_if_cold();
+	}
+	clauses_at_compaction = clauses.size();
+}
+
+std::shared_ptr<const Clause> SolverShadowBase::clause_by_cref(int cref) const
 {
 	assert(cref_map.count(cref) > 0);
 	int clause_index = cref_map.at(cref);
@@ -188,7 +240,7 @@ std::shared_ptr<const Clause> SolverShadow::clause_by_cref(int cref) const
 	return clauses[clause_index];
 }
 
-std::shared_ptr<const Clause> SolverShadow::unit_clause(const Literal& l) const
+std::shared_ptr<const Clause> SolverShadowBase::unit_clause(const Literal& l) const
 {
 	assert(unit_map.count(l.variable()) > 0);
 	int clause_index = unit_map.at(l.variable());
@@ -196,19 +248,29 @@ std::shared_ptr<const Clause> SolverShadow::unit_clause(const Literal& l) const
 	return clauses[clause_index];
 }
 
-void SolverShadow::remove_clause(int cref)
+void SolverShadowBase::remove_clause(int cref)
 {
 	int index = cref_map.at(cref);
 	cref_map.erase(cref);
 
 	// If we remove the clause from the list, it will not be part of the 
 	// "unused graph". However, the memory savings are significant.
-	//clauses[index] = std::shared_ptr<const Clause>(nullptr);
+	if(reclaim) clauses[index] = std::shared_ptr<const Clause>(nullptr);
 }
 
-void SolverShadow::relocate(const std::vector<std::pair<int, int> >& moves)
+void SolverShadowBase::reclaim_removed(bool enabled)
 {
-	std::map<int, int> new_mapping(cref_map);
+	reclaim = enabled;
+}
+
+void SolverShadowBase::compact_clauses(bool enabled)
+{
+	compact = enabled;
+}
+
+void SolverShadowBase::relocate(const std::vector<std::pair<int, int> >& moves)
+{
+	counted_map<int, int, memory_maps> new_mapping(cref_map);
 
 	for(std::pair<int, int> move : moves)
 	{
@@ -220,12 +282,65 @@ void SolverShadow::relocate(const std::vector<std::pair<int, int> >& moves)
 	}	
 
 	std::swap(new_mapping, cref_map);
+
+	// The solver just collected its garbage, which is a good time to do the
+	// same with ours
+	if(reclaim) sweep_clause_list();
+	if(compact) compact_cold_clauses();
+}
+
+// Drops the entries of reclaimed clauses from the clause list, keeping the
+// order of the others, and renumbers everything that refers to clauses by
+// their position. Only the list shrinks: the clauses themselves stay where
+// they were allocated, since resolvents point to their parents and clauses
+// are identified by address
+void SolverShadowBase::sweep_clause_list()
+{
+	std::vector<int> position(clauses.size(), -1);
+	size_t live = 0;
+	for(size_t i=0; i < clauses.size(); i++)
+	{
+		if(clauses[i] == nullptr) continue;
+		position[i] = (int) live;
+		if(live != i) clauses[live] = std::move(clauses[i]);
+		live++;
+	}
+
+	if(live == clauses.size()) return;
+	clauses.resize(live);
+	clauses.shrink_to_fit();
+
+	if(first_learned_index != -1)
+	{
+		int first = 0;
+		for(int i=0; i < first_learned_index; i++) if(position[i] != -1) first++;
+		first_learned_index = first;
+	}
+
+	for(std::pair<const int, int>& entry : cref_map) entry.second = position[entry.second];
+	for(std::pair<const int, int>& entry : unit_map) entry.second = position[entry.second];
+	for(trail_item& item : trail)
+	{
+		if(std::get<2>(item) != -1) std::get<2>(item) = position[std::get<2>(item)];
+	}
+
+	// Keys start with the position of the clause the literals are skipped
+	// from. Once that clause is gone, its keys can never be looked up again
+	counted_map<std::string, int, memory_maps> renumbered;
+	for(const std::pair<const std::string, int>& entry : clauses_with_ignored)
+	{
+		size_t separator = entry.first.find('_');
+		int from = position[std::stoi(entry.first.substr(0, separator))];
+		if(from == -1) continue;
+		renumbered[std::to_string(from) + entry.first.substr(separator)] = position[entry.second];
+	}
+	std::swap(renumbered, clauses_with_ignored);
 }
 
 // The simple minimization mode, where we remove literals whose reason clause is a subset
 // of in the learned clause
 // We trust the trace output that this is the case and simply resolve with the reason clauses
-clause_ref SolverShadow::minimize(clause_ref initial, std::vector<Literal> to_remove) const
+clause_ref SolverShadowBase::minimize(clause_ref initial, std::vector<Literal> to_remove) const
 {
 	// We require reverse assignment order to guarantee a valid resolution
 	std::sort(to_remove.begin(), to_remove.end(), [&](const Literal & a, const Literal & b) -> bool
@@ -248,7 +363,7 @@ clause_ref SolverShadow::minimize(clause_ref initial, std::vector<Literal> to_re
 }
 
 // The full minimization mode, where we allow temporarily introduced literals
-clause_ref SolverShadow::minimize_full(clause_ref initial, std::vector<Literal> to_remove) const
+clause_ref SolverShadowBase::minimize_full(clause_ref initial, std::vector<Literal> to_remove) const
 {
 	// Start with the literals to be removed and in reverse trail order,
 	// resolve with reason clauses. Literals in the reason are guaranteed
@@ -299,7 +414,7 @@ clause_ref SolverShadow::minimize_full(clause_ref initial, std::vector<Literal>
 	return remaining;
 }
 
-void SolverShadow::dump_trail() const
+void SolverShadowBase::dump_trail() const
 {
 	for(int i=0; i < trail.size(); i++)
 	{
@@ -309,3 +424,7 @@ void SolverShadow::dump_trail() const
 		std::cout << std::endl;
 	}
 }
+
+template class SolverShadow<none>;
+template class SolverShadow<learn>;
+template class SolverShadow<resolve_unit>;
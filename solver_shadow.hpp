@@ -7,10 +7,13 @@
 #include <assert.h>
 #include "clause.hpp"
 #include "literal.hpp"
+#include "memory_accounting.hpp"
 
 enum ignore_mode { none=0, learn, resolve_unit };
 
 typedef std::shared_ptr<const Clause> clause_ref;
+struct snapshot_header;
+struct refutation_marks;
 // decision level, assignment, reason clause index, reason clause pointer
 // (pointer only used to allow removing clauses from database without making
 // reference invalid)
@@ -20,10 +23,14 @@ typedef std::tuple<int, const Literal, int, clause_ref> trail_item;
 // Because the graph needs to be reconstructed afterwards, it also contains
 // some information explicitly that minisat keeps implicitly
 // (for example, learned clauses contain references to their resolution chains)
-class SolverShadow
+//
+// The base class holds the state and everything that does not depend on the
+// ignore mode. SolverShadow<mode> below adds the mode dependent handlers, so
+// that the mode is only dispatched on once at startup
+class SolverShadowBase
 {
 public:
-	SolverShadow(ignore_mode _mode);
+	SolverShadowBase();
 	void add_clause(const clause_ref c, int cref);
 	void add_unit(const clause_ref c);
 
@@ -32,14 +39,20 @@ public:
 	void add_unit(const clause_ref c, const Literal l);
 
 	void decide(const Literal l);
-	void propagate(const Literal& l, int cref);
 	void propagate(const Literal& l);
 	void backtrack(int to_level);
 	void num_vars(int num_vars);
 	void restart();
 	void remove_clause(int cref);
+	// Drop removed clauses, so that their memory is freed once no other clause
+	// depends on them. They are then missing from the unused part of the graph.
+	// Relocations (M/RD) then also drop their entries from the clause list
+	void reclaim_removed(bool enabled);
+	// Compact the clauses that are not reasons on the trail and were not
+	// resolved since the previous sweep (see Clause::compact_if_cold), in
+	// sweeps at restarts and relocations
+	void compact_clauses(bool enabled);
 	void relocate(const std::vector<std::pair<int, int> >& moves);
-	clause_ref skip(int cref, std::vector<Literal>& skipped);
 	clause_ref minimize(clause_ref initial, std::vector<Literal> to_remove) const;
 	// Full is the mode that allows temporary new literals (intermediate steps in the
 	// implication graph)
@@ -49,19 +62,40 @@ public:
 	std::shared_ptr<const Clause> unit_clause(const Literal& l) const;
 
 	void dump_trail() const;
+	int num_live_clauses() const;
+	int trail_size() const;
+	// Whether l is assigned by a decision (with an incremental solver, an
+	// assumption)
+	bool decided(const Literal& l) const;
 
 	friend class ResolutionGraph;
-private:
+	friend class ProofDag;
+	friend void write_snapshot(std::ostream& out, const SolverShadowBase& solver, const refutation_marks& marks, const snapshot_header& header);
+	friend bool read_snapshot(std::istream& in, SolverShadowBase& solver, refutation_marks& marks, snapshot_header& header);
+protected:
 	int num_vars() const;
+	void compact_cold_clauses();
+	void sweep_clause_list();
 
-	std::vector<clause_ref> clauses;
-	std::map<int, int> cref_map;
-	std::map<int, int> unit_map;
-	std::vector<int> index;
+	counted_vector<clause_ref, memory_clause_list> clauses;
+	counted_map<int, int, memory_maps> cref_map;
+	counted_map<int, int, memory_maps> unit_map;
+	counted_vector<int, memory_clause_list> index;
 
 	int decision_level;
-	std::vector<trail_item> trail;
+	counted_vector<trail_item, memory_trail> trail;
 	int first_learned_index;
-	ignore_mode mode;
-	std::map<std::string, int> clauses_with_ignored;
+	counted_map<std::string, int, memory_maps> clauses_with_ignored;
+	bool reclaim;
+	bool compact;
+	size_t clauses_at_compaction;
+};
+
+template<ignore_mode mode>
+class SolverShadow : public SolverShadowBase
+{
+public:
+	using SolverShadowBase::propagate;
+	void propagate(const Literal& l, int cref);
+	clause_ref skip(int cref, std::vector<Literal>& skipped);
 };
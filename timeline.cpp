@@ -0,0 +1,103 @@
+#include "timeline.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+bool timeline_active = false;
+
+namespace
+{
+	// Spans of one thread. The ring grows up to its capacity, after which the
+	// oldest span is overwritten
+	struct timeline_ring
+	{
+		std::vector<timeline_event> events;
+		size_t next = 0;
+		int thread_index;
+	};
+
+	std::chrono::steady_clock::time_point epoch;
+	size_t ring_capacity = 0;
+	int derivation_min_width = 0;
+	long long derivation_min_ns = 0;
+
+	std::mutex rings_mutex;
+	std::vector<std::unique_ptr<timeline_ring> > rings;
+
+	thread_local timeline_ring* own_ring = nullptr;
+
+	timeline_ring& ring()
+	{
+		if(own_ring == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(rings_mutex);
+			rings.emplace_back(new timeline_ring());
+			own_ring = rings.back().get();
+			own_ring->thread_index = rings.size();
+		}
+		return *own_ring;
+	}
+
+	void write_microseconds(std::ostream& out, long long ns)
+	{
+		out << ns / 1000 << "." << (ns % 1000) / 100 << (ns % 100) / 10 << ns % 10;
+	}
+}
+
+void enable_timeline(size_t capacity, int min_width, double min_microseconds)
+{
+	ring_capacity = capacity > 0 ? capacity : 1;
+	derivation_min_width = min_width;
+	derivation_min_ns = min_microseconds * 1000;
+	epoch = std::chrono::steady_clock::now();
+	timeline_active = true;
+}
+
+long long timeline_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+bool timeline_keeps_derivation(int width, long long duration_ns)
+{
+	return width >= derivation_min_width || duration_ns >= derivation_min_ns;
+}
+
+void timeline_record(const char* name, const char* category, long long start_ns, long long end_ns, const char* arg_name, long long arg)
+{
+	timeline_ring& r = ring();
+	timeline_event e{name, category, start_ns, end_ns - start_ns, arg_name, arg};
+
+	if(r.events.size() < ring_capacity) r.events.push_back(e);
+	else r.events[r.next] = e;
+	r.next = (r.next + 1) % ring_capacity;
+}
+
+void write_timeline(std::ostream& out)
+{
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	out << "{\"traceEvents\": [";
+	bool first = true;
+
+	for(const std::unique_ptr<timeline_ring>& r : rings)
+	{
+		out << (first ? "" : ",") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << r->thread_index
+			<< ", \"args\": {\"name\": \"thread " << r->thread_index << "\"}}";
+		first = false;
+
+		// Oldest first, which is at next once the ring is full
+		size_t begin = r->events.size() < ring_capacity ? 0 : r->next;
+		for(size_t i=0; i < r->events.size(); i++)
+		{
+			const timeline_event& e = r->events[(begin + i) % r->events.size()];
+			out << ",\n{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << r->thread_index << ", \"ts\": ";
+			write_microseconds(out, e.start_ns);
+			out << ", \"dur\": ";
+			write_microseconds(out, e.duration_ns);
+			if(e.arg_name != nullptr) out << ", \"args\": {\"" << e.arg_name << "\": " << e.arg << "}";
+			out << "}";
+		}
+	}
+
+	out << "\n], \"displayTimeUnit\": \"ms\"}" << std::endl;
+}
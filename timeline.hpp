@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+// Optional timeline of individual spans (restart intervals, slow or wide
+// learned clause derivations, relocations, the final graph build), written
+// as Chrome trace-event JSON for chrome://tracing or Perfetto. Every thread
+// records into its own fixed size ring, so recording takes no lock and a
+// long run keeps its most recent spans
+struct timeline_event
+{
+	// Names are string literals, so that recording does not allocate
+	const char* name;
+	const char* category;
+	long long start_ns;
+	long long duration_ns;
+	const char* arg_name;
+	long long arg;
+};
+
+extern bool timeline_active;
+
+// Starts recording, keeping at most capacity spans per thread. Learned
+// clause derivations are only recorded if the clause has at least min_width
+// literals or took at least min_microseconds to derive
+void enable_timeline(size_t capacity, int min_width, double min_microseconds);
+bool timeline_keeps_derivation(int width, long long duration_ns);
+
+// Nanoseconds since the timeline was enabled
+long long timeline_now();
+
+// Records a span of the calling thread. arg_name may be nullptr
+void timeline_record(const char* name, const char* category, long long start_ns, long long end_ns, const char* arg_name = nullptr, long long arg = 0);
+
+// Writes the spans of every thread as a single trace-event JSON object. No
+// other thread may be recording at the same time
+void write_timeline(std::ostream& out);
+
+// Records the lifetime of the scope as a span, if the timeline is active
+class TimelineSpan
+{
+public:
+	TimelineSpan(const char* _name, const char* _category, const char* _arg_name = nullptr, long long _arg = 0) :
+		name(_name), category(_category), arg_name(_arg_name), arg(_arg), start(timeline_active ? timeline_now() : 0)
+	{
+	}
+	~TimelineSpan()
+	{
+		if(timeline_active) timeline_record(name, category, start, timeline_now(), arg_name, arg);
+	}
+
+private:
+	const char* name;
+	const char* category;
+	const char* arg_name;
+	long long arg;
+	long long start;
+};
@@ -0,0 +1,222 @@
+#include "trace_reader.hpp"
+#include "profiler.hpp"
+#include "heartbeat.hpp"
+#include "memory_accounting.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace
+{
+	// Lines between two publications of the progress counters
+	const long long publish_interval = 4096;
+}
+
+template<ignore_mode mode>
+TraceReader<mode>::TraceReader(std::istream& _in, ProofEvents<mode>& _events, bool _print_input) :
+	in(_in), events(_events), print_input(_print_input), lines_read(0), bytes_read(0), threads(1), tokenizer_chunk_size(1 << 22), chunk_position(0), snapshot_interval(0), restarts_since_snapshot(0), analyze_pending(false), analyze_ref(-1)
+{
+}
+
+template<ignore_mode mode>
+bool TraceReader<mode>::read_until_conflict(int& conflict_ref)
+{
+	PROFILE_SCOPE(phase_trace_replay);
+	trace_event event;
+
+	while(next_event(event))
+	{
+		PROFILE_COUNT(counter_lines, event.lines);
+		bytes_read += event.bytes;
+		long long previous_lines = lines_read;
+		lines_read += event.lines;
+		if(lines_read / publish_interval != previous_lines / publish_interval) publish_progress();
+
+		// Any line other than S ends the skip list of a pending U
+		if(analyze_pending && event.instruction != instruction_skip) flush_analyze();
+
+		if(event.instruction == instruction_conflict)
+		{
+			conflict_ref = event.number;
+			publish_progress();
+			return true;
+		}
+
+		apply(event);
+		if( ! events.consistent()) return false;
+
+		// A restart never falls inside a conflict analysis, but could in
+		// principle fall between M and RD, in which case the snapshot waits
+		// for the next restart
+		if(snapshot_interval > 0 && event.instruction == instruction_restart && ++restarts_since_snapshot >= snapshot_interval && moves.empty())
+		{
+			snapshot();
+			restarts_since_snapshot = 0;
+		}
+	}
+
+	if(analyze_pending) flush_analyze();
+	publish_progress();
+	return false;
+}
+
+template<ignore_mode mode>
+bool TraceReader<mode>::next_event(trace_event& event)
+{
+	if(threads > 1)
+	{
+		// The tokenizer starts reading where the input is positioned by then,
+		// which may be after a resumed snapshot
+		if(tokenizer == nullptr) tokenizer.reset(new TraceTokenizer(in, threads, tokenizer_chunk_size));
+
+		while(chunk_position == chunk.size())
+		{
+			chunk.clear();
+			chunk_position = 0;
+			if( ! tokenizer->next(chunk)) return false;
+		}
+
+		event = std::move(chunk[chunk_position++]);
+		return true;
+	}
+
+	if( ! std::getline(in, line)) return false;
+	parse_trace_line(line.data(), line.data() + line.size(), event);
+
+	if(print_input)
+	{
+		std::cout << line << std::endl;
+
+		// Unknown instructions are printed once more on their own
+		if(event.instruction == instruction_other)
+		{
+			std::string instruction;
+			std::istringstream(line) >> instruction;
+			std::cout << instruction << std::endl;
+		}
+	}
+
+	return true;
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::snapshot_at_restarts(const std::string& path, int interval)
+{
+	snapshot_path = path;
+	snapshot_interval = interval;
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::resume(long long offset, long long lines)
+{
+	bytes_read = offset;
+	lines_read = lines;
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::tokenize_in_parallel(int _threads, size_t chunk_size)
+{
+	threads = _threads;
+	tokenizer_chunk_size = chunk_size;
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::snapshot() const
+{
+	std::string temporary = snapshot_path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ofstream::binary);
+		events.save(out, bytes_read, lines_read);
+	}
+	std::rename(temporary.c_str(), snapshot_path.c_str());
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::publish_progress() const
+{
+	const event_counts& counts = events.counts();
+	publish(progress.lines, lines_read);
+	publish(progress.events, counts.events);
+	publish(progress.learned, counts.learned);
+	publish(progress.restarts, counts.restarts);
+	publish(progress.relocations, counts.relocations);
+	publish(progress.live_clauses, events.shadow().num_live_clauses());
+	publish(progress.trail_size, events.shadow().trail_size());
+	publish(progress.memory_bytes, memory_total_bytes());
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::flush_analyze()
+{
+	analyze_pending = false;
+	events.on_analyze(analyze_ref, to_skip);
+	to_skip.clear();
+}
+
+template<ignore_mode mode>
+void TraceReader<mode>::apply(const trace_event& event)
+{
+	switch(event.instruction)
+	{
+		case instruction_num_vars:
+			events.on_num_vars(event.number);
+			break;
+		case instruction_input:
+			events.on_input_clause(event.number, event.literals);
+			break;
+		case instruction_decide:
+			events.on_decide(event.literal);
+			break;
+		case instruction_propagate:
+			events.on_propagate(event.literal, event.number);
+			break;
+		case instruction_propagate_unit:
+			events.on_propagate_unit(event.literal);
+			break;
+		case instruction_analyze:
+			// Carries the S lines after it if the tokenizer grouped them
+			analyze_ref = event.number;
+			analyze_pending = true;
+			to_skip.insert(to_skip.end(), event.literals.begin(), event.literals.end());
+			break;
+		case instruction_skip:
+			to_skip.insert(to_skip.end(), event.literals.begin(), event.literals.end());
+			break;
+		case instruction_minimize:
+			events.on_minimize(event.literals);
+			break;
+		case instruction_minimize_full:
+			events.on_minimize_full(event.literals);
+			break;
+		case instruction_learn:
+			events.on_learn(event.number, event.literals);
+			break;
+		case instruction_learn_unit:
+			events.on_learn_unit(event.literal);
+			break;
+		case instruction_backtrack:
+			events.on_backtrack(event.number);
+			break;
+		case instruction_restart:
+			events.on_restart();
+			break;
+		case instruction_remove:
+			events.on_remove(event.number);
+			break;
+		case instruction_move:
+			moves.push_back(std::make_pair(event.number, event.other));
+			break;
+		case instruction_relocate:
+			if(moves.empty()) break;
+			events.on_relocate(moves);
+			moves.clear();
+			break;
+		default:
+			break;
+	}
+}
+
+template class TraceReader<none>;
+template class TraceReader<learn>;
+template class TraceReader<resolve_unit>;
@@ -0,0 +1,69 @@
+#pragma once
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include "literal.hpp"
+#include "proof_events.hpp"
+#include "trace_tokenizer.hpp"
+
+// TraceReader replays a minisat text trace through ProofEvents, which makes
+// the text trace just another client of the event interface
+template<ignore_mode mode>
+class TraceReader
+{
+public:
+	TraceReader(std::istream& _in, ProofEvents<mode>& _events, bool _print_input);
+
+	// Applies lines until a final conflict (C) is read, in which case its cref
+	// is stored in conflict_ref and true is returned. Returns false if the
+	// input ends first, or as soon as verification finds a mismatch
+	bool read_until_conflict(int& conflict_ref);
+
+	// Writes a snapshot of the events to path (through a temporary file, so
+	// that a crash never leaves a partial snapshot) after every interval
+	// restarts (RS)
+	void snapshot_at_restarts(const std::string& path, int interval);
+	// Continues counting from a snapshot, whose offset the input has already
+	// been positioned at
+	void resume(long long offset, long long lines);
+	// With more than one thread, the trace is decoded by a TraceTokenizer with
+	// that many workers, while this thread only applies the events. Printing
+	// the input needs the lines, so it only works with one thread. Small
+	// chunks are for testing the cuts between them
+	void tokenize_in_parallel(int threads, size_t chunk_size = 1 << 22);
+
+private:
+	bool next_event(trace_event& event);
+	void apply(const trace_event& event);
+	void flush_analyze();
+	// Publishes the replay's counters for the heartbeat
+	void publish_progress() const;
+	void snapshot() const;
+
+	std::istream& in;
+	ProofEvents<mode>& events;
+	const bool print_input;
+	long long lines_read;
+	long long bytes_read;
+
+	int threads;
+	size_t tokenizer_chunk_size;
+	std::unique_ptr<TraceTokenizer> tokenizer;
+	std::vector<trace_event> chunk;
+	size_t chunk_position;
+	std::string line;
+
+	std::string snapshot_path;
+	int snapshot_interval;
+	int restarts_since_snapshot;
+
+	// A U line is only reported once all S lines following it have been read
+	bool analyze_pending;
+	int analyze_ref;
+	std::vector<Literal> to_skip;
+
+	// M lines are collected until the RD that ends the relocation
+	std::vector<std::pair<int, int> > moves;
+};
@@ -0,0 +1,268 @@
+#include "trace_tokenizer.hpp"
+#include <cstring>
+
+namespace
+{
+	const char* skip_blanks(const char* p, const char* end)
+	{
+		while(p != end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+		return p;
+	}
+
+	// Missing or malformed numbers read as 0
+	int parse_number(const char*& p, const char* end)
+	{
+		p = skip_blanks(p, end);
+		bool negative = p != end && *p == '-';
+		if(negative) p++;
+
+		int value = 0;
+		while(p != end && *p >= '0' && *p <= '9') value = 10 * value + (*p++ - '0');
+		return negative ? -value : value;
+	}
+
+	// Negated literals are written with a leading ~
+	Literal parse_literal(const char*& p, const char* end)
+	{
+		p = skip_blanks(p, end);
+		bool negated = p != end && *p == '~';
+		if(negated) p++;
+		return Literal(parse_number(p, end), negated);
+	}
+
+	void parse_literals(const char*& p, const char* end, int count, std::vector<Literal>& literals)
+	{
+		for(int i=0; i < count; i++) literals.push_back(parse_literal(p, end));
+	}
+
+	struct instruction_name
+	{
+		const char* name;
+		trace_instruction instruction;
+	};
+
+	const instruction_name instruction_names[] = {
+		{"NV", instruction_num_vars}, {"I", instruction_input}, {"D", instruction_decide},
+		{"P", instruction_propagate}, {"PU", instruction_propagate_unit}, {"U", instruction_analyze},
+		{"S", instruction_skip}, {"MNM", instruction_minimize}, {"MNM2", instruction_minimize_full},
+		{"L", instruction_learn}, {"LU", instruction_learn_unit}, {"B", instruction_backtrack},
+		{"RS", instruction_restart}, {"R", instruction_remove}, {"M", instruction_move},
+		{"RD", instruction_relocate}, {"C", instruction_conflict}
+	};
+
+	trace_instruction parse_instruction(const char*& p, const char* end)
+	{
+		p = skip_blanks(p, end);
+		const char* start = p;
+		while(p != end && *p != ' ' && *p != '\t' && *p != '\r') p++;
+
+		size_t length = p - start;
+		for(const instruction_name& n : instruction_names)
+		{
+			if(std::strlen(n.name) == length && std::memcmp(n.name, start, length) == 0) return n.instruction;
+		}
+		return instruction_other;
+	}
+
+	// Whether the line starting at p is a U or S line
+	bool analyze_line(const char* p, const char* end)
+	{
+		const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		if(line_end == nullptr) line_end = end;
+
+		trace_instruction instruction = parse_instruction(p, line_end);
+		return instruction == instruction_analyze || instruction == instruction_skip;
+	}
+
+	void tokenize(const std::string& text, std::vector<trace_event>& events)
+	{
+		const char* p = text.data();
+		const char* end = p + text.size();
+
+		while(p != end)
+		{
+			const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			if(line_end == nullptr) line_end = end;
+
+			trace_event event;
+			parse_trace_line(p, line_end, event);
+			event.bytes = line_end - p + 1;
+			p = line_end == end ? end : line_end + 1;
+
+			// S lines directly after a U are added to it
+			if(event.instruction == instruction_skip && ! events.empty() && events.back().instruction == instruction_analyze)
+			{
+				trace_event& analyze = events.back();
+				analyze.literals.insert(analyze.literals.end(), event.literals.begin(), event.literals.end());
+				analyze.lines++;
+				analyze.bytes += event.bytes;
+			}
+			else events.push_back(std::move(event));
+		}
+	}
+}
+
+void parse_trace_line(const char* begin, const char* end, trace_event& event)
+{
+	const char* p = begin;
+	event.instruction = parse_instruction(p, end);
+	event.literals.clear();
+	event.lines = 1;
+	event.bytes = end - begin + 1;
+
+	switch(event.instruction)
+	{
+		case instruction_num_vars:
+		case instruction_analyze:
+		case instruction_backtrack:
+		case instruction_remove:
+		case instruction_conflict:
+			event.number = parse_number(p, end);
+			break;
+		case instruction_input:
+		case instruction_learn:
+			event.number = parse_number(p, end);
+			parse_literals(p, end, parse_number(p, end), event.literals);
+			break;
+		case instruction_skip:
+		case instruction_minimize:
+		case instruction_minimize_full:
+			parse_literals(p, end, parse_number(p, end), event.literals);
+			break;
+		case instruction_decide:
+		case instruction_propagate_unit:
+		case instruction_learn_unit:
+			event.literal = parse_literal(p, end);
+			break;
+		case instruction_propagate:
+			event.literal = parse_literal(p, end);
+			event.number = parse_number(p, end);
+			break;
+		case instruction_move:
+			event.number = parse_number(p, end);
+			event.other = parse_number(p, end);
+			break;
+		default:
+			break;
+	}
+}
+
+TraceTokenizer::TraceTokenizer(std::istream& _in, int threads, size_t _chunk_size) :
+	in(_in), chunk_size(_chunk_size), max_chunks(2 * threads), next_chunk(0), num_chunks(-1), stopping(false)
+{
+	reader = std::thread(&TraceTokenizer::read, this);
+	for(int i=0; i < threads; i++) workers.push_back(std::thread(&TraceTokenizer::work, this));
+}
+
+TraceTokenizer::~TraceTokenizer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	changed.notify_all();
+
+	reader.join();
+	for(std::thread& worker : workers) worker.join();
+}
+
+bool TraceTokenizer::next(std::vector<trace_event>& events)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [this] { return parsed.count(next_chunk) > 0 || next_chunk == num_chunks; });
+	if(next_chunk == num_chunks) return false;
+
+	auto it = parsed.find(next_chunk);
+	events.swap(it->second);
+	parsed.erase(it);
+	next_chunk++;
+
+	lock.unlock();
+	changed.notify_all();
+	return true;
+}
+
+void TraceTokenizer::read()
+{
+	for(long long chunk=0; ; chunk++)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this, chunk] { return stopping || chunk - next_chunk < max_chunks; });
+			if(stopping) return;
+		}
+
+		std::string text;
+		bool more = read_chunk(text);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if( ! text.empty()) unparsed.push_back(std::make_pair(chunk, std::move(text)));
+			else chunk--;
+			if( ! more) num_chunks = chunk + 1;
+		}
+		changed.notify_all();
+
+		if( ! more) return;
+	}
+}
+
+void TraceTokenizer::work()
+{
+	while(true)
+	{
+		std::pair<long long, std::string> chunk;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this] { return stopping || ! unparsed.empty() || num_chunks != -1; });
+			if(stopping || unparsed.empty()) return;
+
+			chunk = std::move(unparsed.front());
+			unparsed.pop_front();
+		}
+
+		std::vector<trace_event> events;
+		tokenize(chunk.second, events);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			parsed[chunk.first].swap(events);
+		}
+		changed.notify_all();
+	}
+}
+
+bool TraceTokenizer::read_chunk(std::string& text)
+{
+	text.swap(carry);
+	carry.clear();
+
+	while(true)
+	{
+		size_t start = text.size();
+		text.resize(start + chunk_size);
+		in.read(&text[start], chunk_size);
+		text.resize(start + in.gcount());
+
+		// The rest of the input, whether it ends with a newline or not
+		if(in.gcount() == 0) return false;
+
+		// Cut after the last complete line that is neither U nor S
+		size_t cut = text.rfind('\n');
+		cut = cut == std::string::npos ? 0 : cut + 1;
+		while(cut > 0)
+		{
+			size_t line = cut == 1 ? std::string::npos : text.rfind('\n', cut - 2);
+			line = line == std::string::npos ? 0 : line + 1;
+			if( ! analyze_line(text.data() + line, text.data() + cut - 1)) break;
+			cut = line;
+		}
+
+		if(cut > 0)
+		{
+			carry.assign(text, cut, std::string::npos);
+			text.resize(cut);
+			return true;
+		}
+	}
+}
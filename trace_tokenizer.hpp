@@ -0,0 +1,96 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "literal.hpp"
+
+// The instructions of a minisat trace
+enum trace_instruction
+{
+	// Empty lines and unknown instructions
+	instruction_other = 0,
+	instruction_num_vars,      // NV
+	instruction_input,         // I
+	instruction_decide,        // D
+	instruction_propagate,     // P
+	instruction_propagate_unit,// PU
+	instruction_analyze,       // U
+	instruction_skip,          // S
+	instruction_minimize,      // MNM
+	instruction_minimize_full, // MNM2
+	instruction_learn,         // L
+	instruction_learn_unit,    // LU
+	instruction_backtrack,     // B
+	instruction_restart,       // RS
+	instruction_remove,        // R
+	instruction_move,          // M
+	instruction_relocate,      // RD
+	instruction_conflict       // C
+};
+
+// A decoded trace line. number holds the cref, count or level of the line
+// (the source of M), other the target of M, literal the literal of D, P,
+// PU and LU, and literals the literal list of I, S, MNM, MNM2 and L
+//
+// When lines are grouped, a U event also carries the literals of the S lines
+// that follow it, and lines and bytes cover all of them
+struct trace_event
+{
+	trace_instruction instruction = instruction_other;
+	int number = 0;
+	int other = 0;
+	Literal literal{0, false};
+	std::vector<Literal> literals;
+	int lines = 0;
+	long long bytes = 0;
+};
+
+// Decodes the line [begin, end), which does not include the newline
+void parse_trace_line(const char* begin, const char* end, trace_event& event);
+
+// TraceTokenizer decodes a trace on several threads. A reader thread cuts the
+// input into chunks of about chunk_size bytes at line boundaries, never right
+// after a U or S line, so that every U is in the same chunk as its S lines.
+// The worker threads decode chunks into events, grouping U and S, and next
+// hands the chunks out in trace order
+//
+// At most twice as many chunks as there are workers are in memory at a time
+class TraceTokenizer
+{
+public:
+	TraceTokenizer(std::istream& _in, int threads, size_t _chunk_size = 1 << 22);
+	~TraceTokenizer();
+
+	// Replaces events with the next chunk. Returns false at the end of the
+	// input
+	bool next(std::vector<trace_event>& events);
+
+private:
+	void read();
+	void work();
+	bool read_chunk(std::string& text);
+
+	std::istream& in;
+	const size_t chunk_size;
+	const long long max_chunks;
+	// The start of a line that belongs to the next chunk
+	std::string carry;
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<std::pair<long long, std::string> > unparsed;
+	std::map<long long, std::vector<trace_event> > parsed;
+	long long next_chunk;
+	// -1 until the reader is at the end of the input
+	long long num_chunks;
+	bool stopping;
+
+	std::thread reader;
+	std::vector<std::thread> workers;
+};
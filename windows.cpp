@@ -0,0 +1,36 @@
+#include "windows.hpp"
+
+long long window_width = 0;
+std::vector<window_stats> learned_windows;
+
+namespace
+{
+	void write_mean(std::ostream& out, long long sum, long long count)
+	{
+		if(count == 0) out << "null";
+		else out << (double) sum / count;
+	}
+}
+
+void enable_windows(long long width)
+{
+	window_width = width;
+}
+
+void print_windows(std::ostream& out)
+{
+	out << "{\"window_width\": " << window_width << ", \"windows\": [";
+	for(size_t i=0; i < learned_windows.size(); i++)
+	{
+		const window_stats& w = learned_windows[i];
+		out << (i == 0 ? "" : ", ") << "{\"first\": " << i * window_width + 1
+			<< ", \"restarts\": [" << w.first_restart << ", " << w.last_restart << "]"
+			<< ", \"learned\": " << w.learned << ", \"used\": " << w.used << ", \"unused\": " << w.learned - w.used
+			<< ", \"mean_width\": ";
+		write_mean(out, w.width, w.learned);
+		out << ", \"mean_used_width\": ";
+		write_mean(out, w.used_width, w.used);
+		out << ", \"tree_edge_violations\": " << w.tree_edge_violations << "}";
+	}
+	out << "]}" << std::endl;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <ostream>
+#include <vector>
+
+// Usefulness of learned clauses over the course of the search, collected by
+// --window. Learned clauses are numbered from 1 in the order they are learned
+// (see Clause::learned_ordinal), and window w aggregates those numbered
+// (w * width, (w + 1) * width]: how many were learned and in which restarts,
+// their widths, how many of them the proof uses, and how often they are used
+// again (tree edge violations)
+//
+// There is one entry per window, filled in as clauses are learned and as the
+// used traversal reaches them, so no pass over the learned clauses is needed
+struct window_stats
+{
+	long long learned = 0, used = 0, tree_edge_violations = 0;
+	long long width = 0, used_width = 0;
+	long long first_restart = -1, last_restart = -1;
+};
+
+extern long long window_width;
+extern std::vector<window_stats> learned_windows;
+
+inline window_stats& window_of(long long ordinal)
+{
+	size_t w = (ordinal - 1) / window_width;
+	if(learned_windows.size() <= w) learned_windows.resize(w + 1);
+	return learned_windows[w];
+}
+
+inline void window_learned(long long ordinal, long long restart, int width)
+{
+	window_stats& w = window_of(ordinal);
+	if(w.learned++ == 0) w.first_restart = restart;
+	w.last_restart = restart;
+	w.width += width;
+}
+
+// Clauses the shadow derives without the solver learning them have ordinal 0
+// and are not counted
+inline void window_used(long long ordinal, int width)
+{
+	if(ordinal == 0) return;
+	window_stats& w = window_of(ordinal);
+	w.used++;
+	w.used_width += width;
+}
+
+inline void window_violation(long long ordinal)
+{
+	if(ordinal == 0) return;
+	window_of(ordinal).tree_edge_violations++;
+}
+
+void enable_windows(long long width);
+// Writes the learned_windows as a single JSON object
+void print_windows(std::ostream& out);